@@ -0,0 +1,587 @@
+#ifdef TINKER_JSON_SINGLE_FILE
+// TinkerBenchmarkSingle, the library is compiled in this file
+#define TINKER_JSON_IMPLEMENTATION
+#include "tinker_json.h"
+#else
+#include "source/TinkerContext.h"
+#include "source/TinkerCpu.h"
+#include "source/TinkerDocument.h"
+#include "source/TinkerMapper.h"
+#include "source/TinkerPatch.h"
+#include "source/TinkerProfiler.h"
+#include "source/TinkerStream.h"
+#include "source/TinkerValidator.h"
+#include "source/TinkerValue.h"
+#endif
+#ifdef TINKER_JSON_ZLIB
+#include "source/TinkerGzip.h"
+#include <zlib.h>
+#endif
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace Tinker;
+
+/*
+ * Global Variables, count the heap allocations of the process.
+ */
+std::atomic<size_t> gAllocations(0);
+std::atomic<size_t> gAllocatedBytes(0);
+
+/*
+ * The hooks are not inlined: when the library is in the same file,
+ * GCC would see free() inlined next to a call of operator new and warn
+ * about a mismatched pair (-Wmismatched-new-delete).
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define BENCHMARK_HOOK __attribute__((noinline))
+#else
+#define BENCHMARK_HOOK
+#endif
+
+BENCHMARK_HOOK void* operator new(size_t size) {
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  void *pointer = malloc(size == 0 ? 1 : size);
+  if(pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+BENCHMARK_HOOK void operator delete(void *pointer) noexcept {
+  free(pointer);
+}
+
+BENCHMARK_HOOK void operator delete(void *pointer, size_t) noexcept {
+  free(pointer);
+}
+
+/*
+ * Benchmark settings and results.
+ */
+struct Options {
+  int warmup = 2;
+  int repeat = 10;
+  size_t threads = 0;
+  bool json = false;
+  std::vector<std::string> files;
+};
+
+struct Result {
+  std::string file;
+  std::string operation;
+  size_t bytes;
+  size_t operations;
+  std::vector<double> samples;
+  double allocations;
+  double allocated_bytes;
+};
+
+static double Percentile(const std::vector<double> &sorted, double p) {
+  if(sorted.empty()) {
+    return 0.0;
+  }
+  double rank = p / 100.0 * (sorted.size() - 1);
+  size_t low = (size_t)rank;
+  size_t high = (low + 1 < sorted.size() ? low + 1 : low);
+  return sorted[low] + (sorted[high] - sorted[low]) * (rank - low);
+}
+
+static long PeakRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/*
+ * Runs body warmup + repeat times, the samples are in nanoseconds.
+ * Setup runs before every repetition and is not timed.
+ */
+static Result Measure(
+  const Options &options,
+  const std::string &file,
+  const char *operation,
+  size_t bytes,
+  size_t operations,
+  const std::function<void()> &setup,
+  const std::function<void()> &body) {
+  Result result;
+  result.file = file;
+  result.operation = operation;
+  result.bytes = bytes;
+  result.operations = operations;
+  for(int i = 0; i < options.warmup; ++i) {
+    setup();
+    body();
+  }
+  size_t allocations = 0;
+  size_t allocated_bytes = 0;
+  for(int i = 0; i < options.repeat; ++i) {
+    setup();
+    size_t count = gAllocations.load();
+    size_t total = gAllocatedBytes.load();
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto end = std::chrono::steady_clock::now();
+    allocations += gAllocations.load() - count;
+    allocated_bytes += gAllocatedBytes.load() - total;
+    result.samples.push_back(
+      std::chrono::duration<double, std::nano>(end - start).count());
+  }
+  std::sort(result.samples.begin(), result.samples.end());
+  result.allocations = (double)allocations / options.repeat;
+  result.allocated_bytes = (double)allocated_bytes / options.repeat;
+  return result;
+}
+
+/*
+ * Accessor workloads, they follow the shape of the corpus files.
+ * Unknown files only walk their arrays by index.
+ */
+static size_t WalkArrays(const Value &v, double &sum) {
+  size_t lookups = 0;
+  if(v.GetType() == kArray) {
+    size_t size = v.GetArraySize();
+    for(size_t i = 0; i < size; ++i) {
+      lookups += 1 + WalkArrays(v[i], sum);
+    }
+  } else if(v.GetType() == kNumber) {
+    sum += v.GetNumber();
+  }
+  return lookups;
+}
+
+// The twitter.json part of Lookup(), with keys prepared once
+static size_t LookupKeys(const Value &v, double &sum) {
+  static const Key kStatuses("statuses");
+  static const Key kId("id");
+  static const Key kRetweetCount("retweet_count");
+  static const Key kUser("user");
+  static const Key kFollowersCount("followers_count");
+  static const Key kScreenName("screen_name");
+  static const Key kText("text");
+  size_t lookups = 0;
+  for(const Value &status : v[kStatuses].GetElements()) {
+    const Value &user = status[kUser];
+    sum += status[kId].GetNumber();
+    sum += status[kRetweetCount].GetNumber();
+    sum += user[kFollowersCount].GetNumber();
+    sum += user[kScreenName].GetLength();
+    sum += status[kText].GetLength();
+    lookups += 7;
+  }
+  return lookups;
+}
+
+// Visits every node of the tree, returns their number
+static size_t Walk(const Value &v, double &sum) {
+  size_t nodes = 1;
+  if(v.GetType() == kArray) {
+    for(const Value &element : v.GetElements()) {
+      nodes += Walk(element, sum);
+    }
+  } else if(v.GetType() == kObject) {
+    for(Value::ConstMember member : v.GetMembers()) {
+      nodes += Walk(member.value, sum);
+    }
+  } else if(v.GetType() == kNumber) {
+    sum += v.GetNumber();
+  }
+  return nodes;
+}
+
+static size_t Lookup(const std::string &file, const Value &v, double &sum) {
+  size_t lookups = 0;
+  if(file.find("twitter") != std::string::npos) {
+    const Value &statuses = v["statuses"];
+    size_t size = statuses.GetArraySize();
+    for(size_t i = 0; i < size; ++i) {
+      const Value &status = statuses[i];
+      sum += status["id"].GetNumber();
+      sum += status["retweet_count"].GetNumber();
+      sum += status["user"]["followers_count"].GetNumber();
+      sum += status["user"]["screen_name"].GetLength();
+      sum += status["text"].GetLength();
+      lookups += 8;
+    }
+  } else if(file.find("citm_catalog") != std::string::npos) {
+    const Value &performances = v["performances"];
+    size_t size = performances.GetArraySize();
+    for(size_t i = 0; i < size; ++i) {
+      const Value &performance = performances[i];
+      sum += performance["eventId"].GetNumber();
+      const Value &categories = performance["seatCategories"];
+      lookups += 4;
+      for(size_t j = 0; j < categories.GetArraySize(); ++j) {
+        const Value &areas = categories[j]["areas"];
+        lookups += 2;
+        for(size_t k = 0; k < areas.GetArraySize(); ++k) {
+          sum += areas[k]["areaId"].GetNumber();
+          lookups += 2;
+        }
+      }
+    }
+  } else if(v.GetType() == kObject && v.HasKey("features")) {
+    const Value &features = v["features"];
+    for(size_t i = 0; i < features.GetArraySize(); ++i) {
+      lookups += 3 + WalkArrays(features[i]["geometry"]["coordinates"], sum);
+    }
+  } else {
+    lookups = WalkArrays(v, sum);
+  }
+  return lookups;
+}
+
+/*
+ * The fields of twitter.json read by Lookup(), mapped to structs.
+ */
+struct TwitterUser {
+  std::string screen_name;
+  int64_t followers_count;
+};
+TINKER_JSON_FIELDS(TwitterUser, screen_name, followers_count)
+
+struct TwitterStatus {
+  int64_t id;
+  std::string text;
+  int64_t retweet_count;
+  TwitterUser user;
+};
+TINKER_JSON_FIELDS(TwitterStatus, id, text, retweet_count, user)
+
+struct Twitter {
+  std::vector<TwitterStatus> statuses;
+};
+TINKER_JSON_FIELDS(Twitter, statuses)
+
+static void PrintParserStats(const std::string &file, const ParserStats &stats) {
+  printf("> Parser phases of %s:\n", file.c_str());
+  for(int i = 0; i < kPhaseCount; ++i) {
+    printf(">   %-12s %14llu cycles (%5.1f%%) %10llu bytes %10llu calls\n",
+      PhaseString[i],
+      (unsigned long long)stats.cycles[i],
+      stats.cycles[kPhaseParse] == 0 ? 0.0 :
+        stats.cycles[i] * 100.0 / stats.cycles[kPhaseParse],
+      (unsigned long long)stats.bytes[i],
+      (unsigned long long)stats.calls[i]);
+  }
+  printf(">   Tokens:");
+  for(int i = kNull; i <= kObject; ++i) {
+    printf(" %s=%llu", TypeString[i], (unsigned long long)stats.tokens[i]);
+  }
+  printf(" Keys=%llu\n", (unsigned long long)stats.keys);
+}
+
+static bool ReadFile(const std::string &filename, std::string &text) {
+  std::ifstream is(filename.c_str(), std::ifstream::binary);
+  if(!is) {
+    return false;
+  }
+  is.seekg(0, is.end);
+  long long length = is.tellg();
+  is.seekg(0, is.beg);
+  text.resize(length);
+  is.read(&text[0], length);
+  return true;
+}
+
+static void BenchmarkFile(
+  const Options &options,
+  const std::string &file,
+  std::vector<Result> &results) {
+  std::string text;
+  if(!ReadFile(file, text)) {
+    fprintf(stderr, "> Cannot read %s\n", file.c_str());
+    return;
+  }
+  Value document;
+  if(document.Parse(text.c_str()) != kOk) {
+    fprintf(stderr, "> Parsing %s failed!\n", file.c_str());
+    return;
+  }
+  std::string output;
+  document.Stringify(output);
+  size_t stringified = output.length();
+  output.clear();
+  document.Prettify(output);
+  size_t prettified = output.length();
+  double sum = 0.0;
+  size_t lookups = Lookup(file, document, sum);
+  if(lookups == 0) {
+    lookups = 1;
+  }
+
+  Value v;
+  auto nothing = []() {};
+  auto reset = [&]() { v.Parse("null"); };
+  results.push_back(Measure(options, file, "Parse", text.length(), 1,
+    reset, [&]() { v.Parse(text.c_str()); }));
+  results.push_back(Measure(options, file, "ParseValidateUtf8",
+    text.length(), 1, reset,
+    [&]() { v.Parse(text.c_str(), kParseValidateUtf8); }));
+  // Leaves the raw tree in v for StringifyRawNumbers
+  results.push_back(Measure(options, file, "ParseRawNumbers",
+    text.length(), 1, reset,
+    [&]() { v.Parse(text.c_str(), kParseRawNumbers); }));
+  output.clear();
+  v.Stringify(output);
+  results.push_back(Measure(options, file, "StringifyRawNumbers",
+    output.length(), 1,
+    [&]() { output.clear(); output.shrink_to_fit(); },
+    [&]() { v.Stringify(output); }));
+  results.push_back(Measure(options, file, "Validate", text.length(), 1,
+    nothing, [&]() { Validate(text.c_str(), text.length()); }));
+  results.push_back(Measure(options, file, "ValidateUtf8", text.length(), 1,
+    nothing, [&]() {
+      Validate(text.c_str(), text.length(), kParseValidateUtf8);
+    }));
+  // The largest array of each file, one element at a time
+  std::string items = (file.find("twitter") != std::string::npos ?
+    "/statuses" : file.find("citm") != std::string::npos ?
+    "/performances" : file.find("canada") != std::string::npos ?
+    "/features" : "");
+  results.push_back(Measure(options, file, "ArrayReader", text.length(), 1,
+    nothing, [&]() {
+      ArrayReader reader(text.c_str(), items);
+      while(reader.Next(v)) {
+      }
+    }));
+#ifdef TINKER_JSON_ZLIB
+  // The same, decompressed in the reader or ahead of it in a thread
+  uLongf size = compressBound(text.length());
+  std::string deflated(size, '\0');
+  compress2((Bytef *)&deflated[0], &size, (const Bytef *)text.data(),
+            text.length(), Z_DEFAULT_COMPRESSION);
+  deflated.resize(size);
+  for(int background = 0; background < 2; ++background) {
+    results.push_back(Measure(options, file,
+      background ? "GzipInBackground" : "Gzip", text.length(), 1,
+      nothing, [&]() {
+        size_t position = 0;
+        GzipReader gzip([&](char *buffer, size_t size) {
+          size_t count = std::min(size, deflated.length() - position);
+          memcpy(buffer, deflated.data() + position, count);
+          position += count;
+          return count;
+        }, background != 0);
+        ArrayReader reader(gzip.GetReadFunction(), items);
+        while(reader.Next(v)) {
+        }
+      }));
+  }
+#endif
+  auto parse = [&]() { v.Parse(text.c_str()); };
+  results.push_back(Measure(options, file, "Free", text.length(), 1,
+    parse, [&]() { v.Parse("null"); }));
+  results.push_back(Measure(options, file, "FreeInBackground",
+    text.length(), 1,
+    [&]() { WaitForBackgroundFree(); v.Parse(text.c_str()); },
+    [&]() { v.FreeInBackground(); }));
+  WaitForBackgroundFree();
+  results.push_back(Measure(options, file, "FreezeDeduplicate",
+    text.length(), 1, parse, [&]() {
+      SharedDocument::Snapshot snapshot;
+      SharedDocument::Freeze(v, snapshot, kFreezeDeduplicate);
+    }));
+  ParserContext context;
+  results.push_back(Measure(options, file, "ParseContext", text.length(), 1,
+    nothing, [&]() { v.Parse(text.c_str(), context); }));
+  v.Parse("null");
+  results.push_back(Measure(options, file, "Stringify", stringified, 1,
+    [&]() { output.clear(); output.shrink_to_fit(); },
+    [&]() { document.Stringify(output); }));
+  output.clear();
+  document.Stringify(output, kStringifyEnsureAscii);
+  results.push_back(Measure(options, file, "StringifyAscii", output.length(),
+    1, [&]() { output.clear(); output.shrink_to_fit(); },
+    [&]() { document.Stringify(output, kStringifyEnsureAscii); }));
+  results.push_back(Measure(options, file, "Prettify", prettified, 1,
+    [&]() { output.clear(); output.shrink_to_fit(); },
+    [&]() { document.Prettify(output); }));
+  results.push_back(Measure(options, file, "Lookup", 0, lookups,
+    nothing, [&]() { Lookup(file, document, sum); }));
+  if(file.find("twitter") != std::string::npos) {
+    size_t keys = LookupKeys(document, sum);
+    results.push_back(Measure(options, file, "LookupKeys", 0, keys,
+      nothing, [&]() { LookupKeys(document, sum); }));
+  }
+  size_t nodes = Walk(document, sum);
+  results.push_back(Measure(options, file, "Walk", 0, nodes,
+    nothing, [&]() { Walk(document, sum); }));
+  Value same;
+  same.Parse(text.c_str());
+  results.push_back(Measure(options, file, "Diff", text.length(), 1,
+    nothing, [&]() {
+      Value patch;
+      Diff(document, same, patch);
+    }));
+  results.push_back(Measure(options, file, "Equal", text.length(), 1,
+    nothing, [&]() { (void)(document == same); }));
+  const Value &unkept = same;
+  results.push_back(Measure(options, file, "Hash", text.length(), 1,
+    nothing, [&]() { unkept.GetHash(); }));
+  results.push_back(Measure(options, file, "HashKept", text.length(), 1,
+    nothing, [&]() { same.GetHash(); }));
+  // One member of the root changes between two stringifications
+  same.Stringify(output, kStringifyCached);
+  results.push_back(Measure(options, file, "StringifyCached", stringified, 1,
+    [&]() {
+      output.clear();
+      Value patch("[{\"op\":\"add\",\"path\":\"/tinker\",\"value\":1}]");
+      ApplyPatch(same, patch);
+    },
+    [&]() { same.Stringify(output, kStringifyCached); }));
+  if(file.find("twitter") != std::string::npos) {
+    Twitter twitter;
+    results.push_back(Measure(options, file, "ParseStruct", text.length(), 1,
+      nothing, [&]() { Tinker::Parse(text.c_str(), twitter); }));
+    output.clear();
+    Tinker::Stringify(twitter, output);
+    size_t mapped = output.length();
+    results.push_back(Measure(options, file, "StringifyStruct", mapped, 1,
+      [&]() { output.clear(); output.shrink_to_fit(); },
+      [&]() { Tinker::Stringify(twitter, output); }));
+  }
+  if(IsParserProfilingEnabled() && !options.json) {
+    ResetParserStats();
+    v.Parse(text.c_str());
+    PrintParserStats(file, GetParserStats());
+  }
+  if(options.threads > 1) {
+    results.push_back(Measure(options, file, "ParseParallel",
+      text.length(), 1, reset,
+      [&]() { v.ParseParallel(text.c_str(), options.threads); }));
+    results.push_back(Measure(options, file, "StringifyParallel",
+      stringified, 1,
+      [&]() { output.clear(); output.shrink_to_fit(); },
+      [&]() { document.StringifyParallel(output, options.threads); }));
+  }
+}
+
+/*
+ * Reporters.
+ */
+static void PrintTable(const std::vector<Result> &results) {
+  printf("%-24s %-18s %10s %12s %12s %12s %12s %10s\n",
+    "File", "Operation", "MB/s", "ns/op p50", "p90", "p99", "min",
+    "allocs");
+  for(size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    double median = Percentile(r.samples, 50);
+    double throughput = (r.bytes > 0 ? r.bytes / (median / 1e9) / 1e6 : 0.0);
+    const char *name = strrchr(r.file.c_str(), '/');
+    printf("%-24s %-18s %10.1f %12.1f %12.1f %12.1f %12.1f %10.0f\n",
+      name == nullptr ? r.file.c_str() : name + 1,
+      r.operation.c_str(),
+      throughput,
+      median / r.operations,
+      Percentile(r.samples, 90) / r.operations,
+      Percentile(r.samples, 99) / r.operations,
+      r.samples.front() / r.operations,
+      r.allocations);
+  }
+  printf("Peak RSS: %ld KB, SIMD: %s\n", PeakRssKb(), SimdLevelString[GetSimdLevel()]);
+}
+
+static void PrintJson(const Options &options, const std::vector<Result> &results) {
+  printf("{\n  \"warmup\": %d,\n  \"repeat\": %d,\n", options.warmup, options.repeat);
+  printf("  \"simd\": \"%s\",\n", SimdLevelString[GetSimdLevel()]);
+  printf("  \"peak_rss_kb\": %ld,\n  \"results\": [", PeakRssKb());
+  for(size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    double median = Percentile(r.samples, 50);
+    double mean = 0.0;
+    for(size_t j = 0; j < r.samples.size(); ++j) {
+      mean += r.samples[j] / r.samples.size();
+    }
+    printf(i == 0 ? "\n" : ",\n");
+    printf("    {\"file\": \"%s\", \"operation\": \"%s\", ",
+      r.file.c_str(), r.operation.c_str());
+    printf("\"bytes\": %zu, \"operations\": %zu, ", r.bytes, r.operations);
+    printf("\"mb_per_s\": %.3f, ",
+      r.bytes > 0 ? r.bytes / (median / 1e9) / 1e6 : 0.0);
+    printf("\"ns_per_op\": {\"min\": %.1f, \"mean\": %.1f, \"p50\": %.1f, "
+      "\"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f}, ",
+      r.samples.front() / r.operations,
+      mean / r.operations,
+      median / r.operations,
+      Percentile(r.samples, 90) / r.operations,
+      Percentile(r.samples, 99) / r.operations,
+      r.samples.back() / r.operations);
+    printf("\"allocations\": %.1f, \"allocated_bytes\": %.1f}",
+      r.allocations, r.allocated_bytes);
+  }
+  printf("\n  ]\n}\n");
+}
+
+static void Usage(const char *program) {
+  fprintf(stderr,
+    "Usage: %s [--warmup N] [--repeat N] [--threads N] [--simd LEVEL] "
+    "[--json] [files...]\n"
+    "LEVEL is scalar, sse2, avx2, avx512 or neon, the best supported one "
+    "by default\n",
+    program);
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  for(int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if(arg == "--json") {
+      options.json = true;
+    } else if(arg == "--warmup" && i + 1 < argc) {
+      options.warmup = atoi(argv[++i]);
+    } else if(arg == "--repeat" && i + 1 < argc) {
+      options.repeat = atoi(argv[++i]);
+    } else if(arg == "--threads" && i + 1 < argc) {
+      options.threads = (size_t)atoi(argv[++i]);
+    } else if(arg == "--simd" && i + 1 < argc) {
+      std::string name = argv[++i];
+      int level = kSimdScalar;
+      while(level <= kSimdNeon && name != SimdLevelString[level]) {
+        ++level;
+      }
+      if(level > kSimdNeon || !SetSimdLevel((SimdLevel)level)) {
+        fprintf(stderr, "SIMD level %s is not supported\n", name.c_str());
+        return 1;
+      }
+    } else if(arg[0] == '-') {
+      Usage(argv[0]);
+      return 1;
+    } else {
+      options.files.push_back(arg);
+    }
+  }
+  if(options.repeat < 1) {
+    options.repeat = 1;
+  }
+  if(options.files.empty()) {
+    options.files.push_back("test/twitter.json");
+    options.files.push_back("test/canada.json");
+    options.files.push_back("test/citm_catalog.json");
+  }
+
+  std::vector<Result> results;
+  for(size_t i = 0; i < options.files.size(); ++i) {
+    BenchmarkFile(options, options.files[i], results);
+  }
+  if(options.json) {
+    PrintJson(options, results);
+  } else {
+    PrintTable(results);
+  }
+  return results.empty() ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+# Project: Tinker_Json_Parser
+# File: Amalgamate.cmake
+# Author: agent
+# Date: 2026/10/19
+#
+# Writes the whole library as one header, run by the amalgamate target:
+#   cmake -DSOURCE_DIR=<source> -DHEADERS=<list> -DSOURCES=<list>
+#         -DOUTPUT=<file> -P Amalgamate.cmake
+# The headers come first, in the order of HEADERS. SOURCES, internal
+# headers included, only compile in the one translation unit which
+# defines TINKER_JSON_IMPLEMENTATION before including it.
+
+if(NOT SOURCE_DIR OR NOT HEADERS OR NOT SOURCES OR NOT OUTPUT)
+  message(FATAL_ERROR "SOURCE_DIR, HEADERS, SOURCES and OUTPUT are required")
+endif()
+
+# Appends a file without its includes of the library's own files
+function(append_file name)
+  file(READ "${SOURCE_DIR}/${name}" content)
+  string(REGEX REPLACE "\n#include \"[^\"\n]*\"" "" content "${content}")
+  file(APPEND "${OUTPUT}" "${content}\n")
+endfunction()
+
+file(WRITE "${OUTPUT}"
+"/*
+ * Project: Tinker_Json_Parser
+ * File: tinker_json.h
+ *
+ * The single-file version of the library, generated by Amalgamate.cmake.
+ * Include it anywhere for the declarations, and in exactly one source
+ * file after defining TINKER_JSON_IMPLEMENTATION for the definitions:
+ *
+ *   #define TINKER_JSON_IMPLEMENTATION
+ *   #include \"tinker_json.h\"
+ */
+
+#ifndef TINKER_JSON_SINGLE_FILE_H
+#define TINKER_JSON_SINGLE_FILE_H
+
+")
+foreach(name ${HEADERS})
+  append_file(${name})
+endforeach()
+file(APPEND "${OUTPUT}" "#ifdef TINKER_JSON_IMPLEMENTATION\n")
+foreach(name ${SOURCES})
+  append_file(${name})
+endforeach()
+file(APPEND "${OUTPUT}" "#endif //TINKER_JSON_IMPLEMENTATION\n\n")
+file(APPEND "${OUTPUT}" "#endif //TINKER_JSON_SINGLE_FILE_H\n")
@@ -10,8 +10,11 @@
 
 #include <cerrno>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -34,6 +37,30 @@ void Error(const char *error_msg) {
   fprintf(stderr, "> ERROR: %s\n", error_msg);
 }
 
+// The longest string kept inside std::string, without allocating
+static const size_t kInlineLength = std::string().capacity();
+
+/*
+ * std::unordered_map only finds std::string keys. Short keys are
+ * built inside std::string, longer ones are copied into a buffer
+ * which keeps its capacity, so lookups do not allocate once it grew
+ * to the longest key. The buffer is thread-local, which costs more
+ * than building a short string.
+ */
+static const std::string& LongKey(const char *key, size_t length) {
+  static thread_local std::string buffer;
+  buffer.assign(key, length);
+  return buffer;
+}
+
+/*
+ * The getters which return references are written once, for const
+ * values, the others give the same references without const.
+ */
+inline const Value& AsConst(Value &value) {
+  return value;
+}
+
 /**
  * Type wrapper
  */
@@ -70,9 +97,36 @@ void Value::SetBoolean(bool boolean) {
  * Number member wrapper
  */
 
+/*
+ * Raw numbers are converted on first access.
+ */
+NumberValue Value::ReadNumber() const {
+  if(_flags & kFlagRawNumber) {
+    return ConvertRawNumber();
+  }
+  NumberValue number;
+  if(_flags & kFlagInt64) {
+    number.kind = NumberValue::kInt64;
+    number.value.int64 = _value._int64;
+  } else if(_flags & kFlagUint64) {
+    number.kind = NumberValue::kUint64;
+    number.value.uint64 = _value._uint64;
+  } else {
+    number.kind = NumberValue::kDouble;
+    number.value.number = _value._number;
+  }
+  return number;
+}
+
 double Value::GetNumber() const {
   if(_type == kNumber) {
-    return _value._number;
+    NumberValue number = ReadNumber();
+    if(number.kind == NumberValue::kInt64) {
+      return (double)number.value.int64;
+    } else if(number.kind == NumberValue::kUint64) {
+      return (double)number.value.uint64;
+    }
+    return number.value.number;
   } else {
     Error("Try to access the numeric value of a non-number object!");
     exit(31);
@@ -85,11 +139,75 @@ void Value::SetNumber(double number) {
   _type = kNumber;
 }
 
+/**
+ * Exact integer member wrapper
+ */
+
+/*
+ * Only integers parsed without fraction and exponent,
+ * or set by SetInt64() and SetUint64(), are stored exactly.
+ * A number stored as double is never reported as an integer.
+ */
+bool Value::IsInt64() const {
+  if(_type != kNumber) {
+    return false;
+  }
+  NumberValue number = ReadNumber();
+  return (number.kind == NumberValue::kInt64) ||
+    (number.kind == NumberValue::kUint64 &&
+      number.value.uint64 <= (uint64_t)INT64_MAX);
+}
+
+bool Value::IsUint64() const {
+  if(_type != kNumber) {
+    return false;
+  }
+  NumberValue number = ReadNumber();
+  return (number.kind == NumberValue::kUint64) ||
+    (number.kind == NumberValue::kInt64 && number.value.int64 >= 0);
+}
+
+int64_t Value::GetInt64() const {
+  if(IsInt64()) {
+    NumberValue number = ReadNumber();
+    return (number.kind == NumberValue::kInt64) ?
+      number.value.int64 : (int64_t)number.value.uint64;
+  } else {
+    Error("Try to access the int64 value of a non-int64 object!");
+    exit(31);
+  }
+}
+
+uint64_t Value::GetUint64() const {
+  if(IsUint64()) {
+    NumberValue number = ReadNumber();
+    return (number.kind == NumberValue::kUint64) ?
+      number.value.uint64 : (uint64_t)number.value.int64;
+  } else {
+    Error("Try to access the uint64 value of a non-uint64 object!");
+    exit(31);
+  }
+}
+
+void Value::SetInt64(int64_t number) {
+  Free();
+  _value._int64 = number;
+  _flags |= kFlagInt64;
+  _type = kNumber;
+}
+
+void Value::SetUint64(uint64_t number) {
+  Free();
+  _value._uint64 = number;
+  _flags |= kFlagUint64;
+  _type = kNumber;
+}
+
 /**
  * String member wrapper
  */
 
-std::string& Value::GetString() const {
+const std::string& Value::GetString() const {
   if(_type == kString) {
     return *(_value._string);
   } else {
@@ -98,6 +216,12 @@ std::string& Value::GetString() const {
   }
 }
 
+// The string may be written through the reference, so it is a change
+std::string& Value::GetString() {
+  MarkDirty();
+  return const_cast<std::string&>(AsConst(*this).GetString());
+}
+
 size_t Value::GetLength() const {
   if(_type == kString) {
     return (_value._string)->length();
@@ -123,7 +247,7 @@ void Value::SetString(const char *str, size_t length) {
  * Array member wrapper
  */
 
-Value & Value::GetElement(size_t index) const {
+const Value& Value::GetElement(size_t index) const {
   if(_type == kArray) {
     return *((_value._array)->at(index));
   } else {
@@ -132,6 +256,10 @@ Value & Value::GetElement(size_t index) const {
   }
 }
 
+Value& Value::GetElement(size_t index) {
+  return const_cast<Value&>(AsConst(*this).GetElement(index));
+}
+
 size_t Value::GetArraySize() const {
   if(_type == kArray) {
     return (_value._array)->size();
@@ -147,11 +275,33 @@ void Value::SetArray(std::vector<Value *> &vec) {
   _type = kArray;
 }
 
+/*
+ *   for(Value &element : v.GetElements()) { ... }
+ */
+Value::Range<Value::ConstElementIterator> Value::GetElements() const {
+  if(_type == kArray) {
+    return Range<ConstElementIterator>(
+      ConstElementIterator((_value._array)->begin()),
+      ConstElementIterator((_value._array)->end()));
+  } else {
+    Error("Try to access the elements of a non-array object!");
+    exit(31);
+  }
+}
+
+Value::Range<Value::ElementIterator> Value::GetElements() {
+  // Reports a wrong type
+  AsConst(*this).GetElements();
+  return Range<ElementIterator>(
+    ElementIterator((_value._array)->begin()),
+    ElementIterator((_value._array)->end()));
+}
+
 /**
  * Object member wrapper
  */
 
-Value& Value::GetValue(const std::string &key) const {
+const Value& Value::GetValue(const std::string &key) const {
   if(_type == kObject) {
     return *((_value._object)->at(key));
   } else {
@@ -160,6 +310,42 @@ Value& Value::GetValue(const std::string &key) const {
   }
 }
 
+const Value& Value::GetValue(const char *key) const {
+  return GetValue(key, strlen(key));
+}
+
+const Value& Value::GetValue(const char *key, size_t length) const {
+  if(length <= kInlineLength) {
+    return GetValue(std::string(key, length));
+  }
+  return GetValue(LongKey(key, length));
+}
+
+const Value& Value::GetValue(const Key &key) const {
+  const Value *value = Find(key);
+  if(value != nullptr) {
+    return *value;
+  }
+  // Reports a missing key or a wrong type as the other getters do
+  return GetValue(key._text);
+}
+
+Value& Value::GetValue(const std::string &key) {
+  return const_cast<Value&>(AsConst(*this).GetValue(key));
+}
+
+Value& Value::GetValue(const char *key) {
+  return const_cast<Value&>(AsConst(*this).GetValue(key));
+}
+
+Value& Value::GetValue(const char *key, size_t length) {
+  return const_cast<Value&>(AsConst(*this).GetValue(key, length));
+}
+
+Value& Value::GetValue(const Key &key) {
+  return const_cast<Value&>(AsConst(*this).GetValue(key));
+}
+
 bool Value::HasKey(const std::string &key) const {
   if(_type == kObject) {
     return ((_value._object)->count(key) > 0);
@@ -169,6 +355,90 @@ bool Value::HasKey(const std::string &key) const {
   }
 }
 
+bool Value::HasKey(const char *key) const {
+  if(_type == kObject) {
+    return (Find(key) != nullptr);
+  } else {
+    Error("Try to access the key of a non-object object!");
+    exit(31);
+  }
+}
+
+bool Value::HasKey(const Key &key) const {
+  if(_type == kObject) {
+    return (Find(key) != nullptr);
+  } else {
+    Error("Try to access the key of a non-object object!");
+    exit(31);
+  }
+}
+
+const Value* Value::Find(const std::string &key) const {
+  if(_type != kObject) {
+    return nullptr;
+  }
+  auto it = (_value._object)->find(key);
+  return (it == (_value._object)->end() ? nullptr : it->second);
+}
+
+const Value* Value::Find(const char *key) const {
+  return Find(key, strlen(key));
+}
+
+const Value* Value::Find(const char *key, size_t length) const {
+  if(_type != kObject) {
+    return nullptr;
+  }
+  if(length <= kInlineLength) {
+    return Find(std::string(key, length));
+  }
+  return Find(LongKey(key, length));
+}
+
+/*
+ * The bucket of a key only depends on its hash and the bucket count,
+ * so the bucket found in one object holds for any object with as many
+ * buckets, and only its few members are compared.
+ */
+const Value* Value::Find(const Key &key) const {
+  if(_type != kObject) {
+    return nullptr;
+  }
+  const std::unordered_map<std::string, Value *> &object = *(_value._object);
+  if(object.empty()) {
+    return nullptr;
+  }
+  /*
+   * The common standard libraries place a hash in the bucket of its
+   * remainder, but the standard leaves it unspecified, so a miss is
+   * confirmed by a regular lookup.
+   */
+  size_t bucket = key._hash % object.bucket_count();
+  for(auto it = object.begin(bucket); it != object.end(bucket); ++it) {
+    if(it->first == key._text) {
+      return it->second;
+    }
+  }
+  auto it = object.find(key._text);
+  return (it == object.end() ? nullptr : it->second);
+}
+
+Value* Value::Find(const std::string &key) {
+  return const_cast<Value*>(AsConst(*this).Find(key));
+}
+
+Value* Value::Find(const char *key) {
+  return const_cast<Value*>(AsConst(*this).Find(key));
+}
+
+Value* Value::Find(const char *key, size_t length) {
+  return const_cast<Value*>(AsConst(*this).Find(key, length));
+}
+
+Value* Value::Find(const Key &key) {
+  return const_cast<Value*>(AsConst(*this).Find(key));
+}
+
 size_t Value::GetObjectSize() const {
   if(_type == kObject) {
     return (_value._object)->size();
@@ -184,6 +454,28 @@ void Value::SetObject(std::unordered_map<std::string, Value *> &obj) {
   _type = kObject;
 }
 
+/*
+ *   for(Value::Member member : v.GetMembers()) { ... }
+ */
+Value::Range<Value::ConstMemberIterator> Value::GetMembers() const {
+  if(_type == kObject) {
+    return Range<ConstMemberIterator>(
+      ConstMemberIterator((_value._object)->begin()),
+      ConstMemberIterator((_value._object)->end()));
+  } else {
+    Error("Try to access the members of a non-object object!");
+    exit(31);
+  }
+}
+
+Value::Range<Value::MemberIterator> Value::GetMembers() {
+  // Reports a wrong type
+  AsConst(*this).GetMembers();
+  return Range<MemberIterator>(
+    MemberIterator((_value._object)->begin()),
+    MemberIterator((_value._object)->end()));
+}
+
 /**
  * Operator Overloading
  */
@@ -195,7 +487,7 @@ void Value::SetObject(std::unordered_map<std::string, Value *> &obj) {
  * It will throw an out_of_range exception,
  * Because it calls the at() function of std::vector.
  */
-Value& Value::operator[] (size_t index) const {
+const Value& Value::operator[] (size_t index) const {
   if(_type == kArray) {
     return *((_value._array)->at(index));
   } else {
@@ -213,7 +505,7 @@ Value& Value::operator[] (size_t index) const {
  * Therefore, the user must first use function HasKey()
  * To check the existence of the key.
  */
-Value& Value::operator[] (const std::string &key) const {
+const Value& Value::operator[] (const std::string &key) const {
   if(_type == kObject) {
     return *((_value._object)->at(key));
   } else {
@@ -221,4 +513,36 @@ Value& Value::operator[] (const std::string &key) const {
     exit(31);
   }
 }
+
+const Value& Value::operator[] (const Key &key) const {
+  return GetValue(key);
+}
+
+Value& Value::operator[] (size_t index) {
+  return const_cast<Value&>(AsConst(*this)[index]);
+}
+
+Value& Value::operator[] (const std::string &key) {
+  return const_cast<Value&>(AsConst(*this)[key]);
+}
+
+Value& Value::operator[] (const Key &key) {
+  return const_cast<Value&>(AsConst(*this)[key]);
+}
+
+/**
+ * Member key
+ */
+
+Key::Key(const char *key)
+  : _text(key), _hash(std::hash<std::string>()(_text)) {
+}
+
+Key::Key(const std::string &key)
+  : _text(key), _hash(std::hash<std::string>()(_text)) {
+}
+
+const std::string& Key::GetText() const {
+  return _text;
+}
 }
@@ -0,0 +1,366 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerCache.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerStream.h"
+#include "source/TinkerValue.h"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+// The position of a node which has no text in the previous output
+static const size_t kNoText = (size_t)-1;
+
+/**
+ * Text cache
+ */
+
+/*
+ * The text of a tree stringified with kStringifyCached, held by the
+ * container at its root. An entry locates the text of a node inside
+ * the text of its parent, so a subtree which did not change is
+ * copied without touching the entries below it.
+ *
+ * Nodes have no parent pointers, so a change cannot reach the cache
+ * of its tree. Every change clears kFlagCached of the node it changes
+ * instead, and Stringify() first walks the tree to clear the flag of
+ * the ancestors of such nodes too. The walk reads each node once but
+ * formats nothing, then only the nodes without the flag are written.
+ *
+ * The cache also keeps the hashes of the strings and containers of
+ * the tree, which GetHash() refreshes the same way with kFlagHashed.
+ * A value whose tree holds the cache of another value drops it, see
+ * Value::FindChanges().
+ */
+class NodeCache {
+ public:
+  NodeCache();
+
+  void Stringify(Value &root, std::string &text, unsigned flags);
+  Value::KeptHashes& GetHashes() { return _hashes; }
+
+ private:
+  struct Entry {
+    const Value *parent;
+    size_t offset;  // From the start of the parent's text
+    size_t length;
+  };
+
+  void Write(
+    Value &value,
+    const Value *parent,
+    size_t parent_old,
+    size_t parent_new,
+    std::string &text);
+  void WriteChildren(
+    Value &value,
+    size_t old_start,
+    size_t start,
+    std::string &text);
+
+  std::string _text;
+  unsigned _flags;
+  bool _written;
+  std::unordered_map<const Value *, Entry> _entries;
+  Value::KeptHashes _hashes;
+};
+
+// The root containers of the trees which keep their text
+struct CachedArray : public std::vector<Value *> {
+  NodeCache cache;
+};
+
+struct CachedObject : public std::unordered_map<std::string, Value *> {
+  NodeCache cache;
+};
+
+NodeCache::NodeCache() : _flags(0), _written(false) {
+}
+
+/*
+ * The entries of removed nodes are only dropped with all the others,
+ * once they outnumber the nodes of the tree. The text is written
+ * again as a whole then, and when the flags change.
+ */
+void NodeCache::Stringify(Value &root, std::string &text, unsigned flags) {
+  size_t nodes = 0;
+  root.FindChanges(Value::kFlagCached, nodes);
+  bool reuse = (_written && flags == _flags && _entries.size() <= 2 * nodes);
+  if(!reuse) {
+    _entries.clear();
+  }
+  if(!reuse || !(root._flags & Value::kFlagCached)) {
+    _flags = flags;
+    std::string fresh;
+    fresh.reserve(_text.length());
+    WriteChildren(root, (reuse ? 0 : kNoText), 0, fresh);
+    _text.swap(fresh);
+    _written = true;
+    root._flags |= Value::kFlagCached;
+  }
+  text += _text;
+}
+
+/*
+ * parent_old is where the text of the parent starts in the old text,
+ * kNoText if it has none, parent_new where it starts in the new one.
+ * A node which moved to another parent is written again.
+ */
+void NodeCache::Write(
+  Value &value,
+  const Value *parent,
+  size_t parent_old,
+  size_t parent_new,
+  std::string &text) {
+  size_t start = text.length();
+  size_t old_start = kNoText;
+  auto it = _entries.find(&value);
+  if(parent_old != kNoText && it != _entries.end() &&
+    it->second.parent == parent) {
+    old_start = parent_old + it->second.offset;
+    if(value._flags & Value::kFlagCached) {
+      text.append(_text, old_start, it->second.length);
+      it->second.offset = start - parent_new;
+      return;
+    }
+  }
+
+  if(value._type == kArray || value._type == kObject) {
+    WriteChildren(value, old_start, start, text);
+  } else {
+    static_cast<const Value &>(value).Stringify(text, _flags);
+  }
+  Entry &entry = _entries[&value];
+  entry.parent = parent;
+  entry.offset = start - parent_new;
+  entry.length = text.length() - start;
+  value._flags |= Value::kFlagCached;
+}
+
+// The brackets and keys of a container, and its children
+void NodeCache::WriteChildren(
+  Value &value,
+  size_t old_start,
+  size_t start,
+  std::string &text) {
+  if(value._type == kArray) {
+    const std::vector<Value *> &array = *(value._value._array);
+    text.push_back('[');
+    for(size_t i = 0; i < array.size(); ++i) {
+      if(i > 0) {
+        text.push_back(',');
+      }
+      Write(*array[i], &value, old_start, start, text);
+    }
+    text.push_back(']');
+  } else {
+    Writer writer(text, _flags);
+    text.push_back('{');
+    bool first = true;
+    for(auto member = (value._value._object)->begin();
+      member != (value._value._object)->end();
+      ++member) {
+      if(!first) {
+        text.push_back(',');
+      }
+      first = false;
+      writer.String(member->first);
+      text.push_back(':');
+      Write(*(member->second), &value, old_start, start, text);
+    }
+    text.push_back('}');
+  }
+}
+
+/**
+ * Value functions
+ */
+
+/*
+ * The cache of a tree lives in the container at its root, which turns
+ * into a CachedArray or a CachedObject on first use. A borrowed
+ * container belongs to its ParserContext, and a scalar has nothing
+ * worth keeping, so they have no cache.
+ */
+NodeCache* Value::GetCache() {
+  if(_flags & kFlagCacheRoot) {
+    if(_type == kArray) {
+      return &(static_cast<CachedArray *>(_value._array)->cache);
+    }
+    return &(static_cast<CachedObject *>(_value._object)->cache);
+  }
+  if(_flags & kFlagBorrowed) {
+    return nullptr;
+  }
+  if(_type == kArray) {
+    CachedArray *array = new CachedArray();
+    array->swap(*(_value._array));
+    delete _value._array;
+    _value._array = array;
+  } else if(_type == kObject) {
+    CachedObject *object = new CachedObject();
+    object->swap(*(_value._object));
+    delete _value._object;
+    _value._object = object;
+  } else {
+    return nullptr;
+  }
+  _flags |= kFlagCacheRoot;
+  return GetCache();
+}
+
+Value::KeptHashes* Value::GetKeptHashes() {
+  NodeCache *cache = GetCache();
+  return (cache == nullptr ? nullptr : &(cache->GetHashes()));
+}
+
+/*
+ * Clears the flag of the containers which hold a node without it,
+ * a changed node, and counts the nodes. Returns whether the value
+ * changed. The tree is walked without recursion.
+ *
+ * A cache held by a container below this one sets the flags of the
+ * nodes it refreshes, which this cache would then take as unchanged,
+ * and the other way around. So a walk drops the caches it meets, and
+ * their whole trees count as changed, for every cache. Only one value
+ * of a tree keeps text and hashes at a time.
+ */
+bool Value::FindChanges(unsigned flag, size_t &nodes) {
+  struct Frame {
+    Value *value;
+    size_t index;
+    std::unordered_map<std::string, Value *>::const_iterator member;
+    bool changed;
+  };
+  std::vector<Frame> stack;
+  Value *value = this;
+  bool changed = false;
+  while(true) {
+    ++nodes;
+    changed = !(value->_flags & flag);
+    bool opened = false;
+    if(value != this && (value->_flags & kFlagCacheRoot)) {
+      nodes += value->DropCaches() - 1;
+      changed = true;
+    } else if(value->_type == kArray || value->_type == kObject) {
+      Frame frame;
+      frame.value = value;
+      frame.index = 0;
+      if(value->_type == kObject) {
+        frame.member = (value->_value._object)->begin();
+      }
+      frame.changed = changed;
+      stack.push_back(frame);
+      opened = true;
+    }
+
+    // Leave the containers whose children were all walked
+    value = nullptr;
+    while(value == nullptr && !stack.empty()) {
+      Frame &frame = stack.back();
+      if(!opened) {
+        frame.changed = frame.changed || changed;
+      }
+      opened = false;
+      if(frame.value->_type == kArray) {
+        const std::vector<Value *> &array = *(frame.value->_value._array);
+        if(frame.index < array.size()) {
+          value = array[frame.index++];
+        }
+      } else if(frame.member != (frame.value->_value._object)->end()) {
+        value = (frame.member++)->second;
+      }
+      if(value == nullptr) {
+        changed = frame.changed;
+        if(changed) {
+          frame.value->_flags &= ~flag;
+        }
+        stack.pop_back();
+      }
+    }
+    if(value == nullptr) {
+      return changed;
+    }
+  }
+}
+
+/*
+ * Drops the caches held in the tree of the value and marks all of
+ * its nodes as changed. Returns the number of nodes.
+ */
+size_t Value::DropCaches() {
+  size_t nodes = 0;
+  std::vector<Value *> pending(1, this);
+  while(!pending.empty()) {
+    Value *value = pending.back();
+    pending.pop_back();
+    ++nodes;
+    value->DropCache();
+    value->MarkDirty();
+    if(value->_type == kArray) {
+      const std::vector<Value *> &array = *(value->_value._array);
+      pending.insert(pending.end(), array.begin(), array.end());
+    } else if(value->_type == kObject) {
+      for(auto member = (value->_value._object)->begin();
+        member != (value->_value._object)->end();
+        ++member) {
+        pending.push_back(member->second);
+      }
+    }
+  }
+  return nodes;
+}
+
+// Turns a root container back into a plain one, without its cache
+void Value::DropCache() {
+  if(!(_flags & kFlagCacheRoot)) {
+    return;
+  }
+  if(_type == kArray) {
+    std::vector<Value *> *array = new std::vector<Value *>();
+    array->swap(*(_value._array));
+    DeleteCacheRoot();
+    _value._array = array;
+  } else {
+    std::unordered_map<std::string, Value *> *object =
+      new std::unordered_map<std::string, Value *>();
+    object->swap(*(_value._object));
+    DeleteCacheRoot();
+    _value._object = object;
+  }
+}
+
+void Value::DeleteCacheRoot() {
+  if(_type == kArray) {
+    delete static_cast<CachedArray *>(_value._array);
+  } else {
+    delete static_cast<CachedObject *>(_value._object);
+  }
+  _flags &= ~kFlagCacheRoot;
+}
+
+void Value::MarkDirty() {
+  _flags &= ~(kFlagCached | kFlagHashed);
+}
+
+ReturnValue Value::StringifyCached(std::string &text, unsigned flags) {
+  NodeCache *cache = GetCache();
+  if(cache == nullptr) {
+    return static_cast<const Value &>(*this).Stringify(text, flags);
+  }
+  cache->Stringify(*this, text, flags);
+  return kOk;
+}
+}
@@ -0,0 +1,319 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerCompare.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerValue.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+// A bijective mix of the 64 bits (the finalizer of MurmurHash3)
+inline uint64_t MixHash(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Hashes 8 bytes at a time, the length seeds the hash
+inline uint64_t HashBytes(const char *data, size_t length) {
+  uint64_t hash = MixHash(length + 0x9E3779B97F4A7C15ULL);
+  while(length >= 8) {
+    uint64_t word;
+    memcpy(&word, data, 8);
+    hash = MixHash(hash ^ word);
+    data += 8;
+    length -= 8;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, data, length);
+  return MixHash(hash ^ tail);
+}
+
+// Elements are combined in order
+inline uint64_t HashElement(uint64_t hash, uint64_t element) {
+  return MixHash(hash ^ element);
+}
+
+// Members by a sum, which does not depend on the order of iteration
+inline uint64_t HashMember(const std::string &key, uint64_t value) {
+  return MixHash(HashBytes(key.data(), key.length()) ^ MixHash(value));
+}
+
+inline uint64_t HashMembers(uint64_t hash, uint64_t members) {
+  return MixHash(hash ^ members);
+}
+
+/*
+ * A container being hashed without recursion,
+ * with what its children hashed so far give.
+ */
+struct Value::HashFrame {
+  explicit HashFrame(const Value &container)
+    : value(&container),
+      array(container._type == kArray ? container._value._array : nullptr),
+      object(container._type == kObject ? container._value._object : nullptr),
+      index(0),
+      hash(container.HashScalar()),
+      members(0) {
+    if(object != nullptr) {
+      member = object->begin();
+    }
+  }
+
+  // The next child to hash, nullptr once they all are
+  Value* Peek() const {
+    if(array != nullptr) {
+      return (index < array->size() ? (*array)[index] : nullptr);
+    }
+    return (member != object->end() ? member->second : nullptr);
+  }
+
+  // Adds the hash of the child given by Peek()
+  void Add(uint64_t child) {
+    if(array != nullptr) {
+      hash = HashElement(hash, child);
+      ++index;
+    } else {
+      members += HashMember(member->first, child);
+      ++member;
+    }
+  }
+
+  uint64_t Finish() const {
+    return (array != nullptr ? hash : HashMembers(hash, members));
+  }
+
+  const Value *value;
+  const std::vector<Value *> *array;
+  const std::unordered_map<std::string, Value *> *object;
+  size_t index;
+  std::unordered_map<std::string, Value *>::const_iterator member;
+  uint64_t hash;
+  uint64_t members;
+};
+
+/**
+ * Comparison functions
+ */
+
+/*
+ * Values are equal when they have the same type and content, numbers
+ * when they have the same value whatever their storage, objects when
+ * they have the same members in any order.
+ */
+bool Value::operator==(const Value &other) const {
+  std::vector<std::pair<const Value *, const Value *> > stack;
+  stack.push_back(std::make_pair(this, &other));
+  while(!stack.empty()) {
+    const Value *left = stack.back().first;
+    const Value *right = stack.back().second;
+    stack.pop_back();
+    if(left == right) {
+      continue;
+    }
+    if(left->_type != right->_type) {
+      return false;
+    }
+    if(left->_type == kNumber) {
+      NumberValue first = NormalizeNumber(left->ReadNumber());
+      NumberValue second = NormalizeNumber(right->ReadNumber());
+      if(first.kind != second.kind ||
+        first.value.uint64 != second.value.uint64) {
+        return false;
+      }
+    } else if(left->_type == kString) {
+      if(*(left->_value._string) != *(right->_value._string)) {
+        return false;
+      }
+    } else if(left->_type == kArray) {
+      const std::vector<Value *> &first = *(left->_value._array);
+      const std::vector<Value *> &second = *(right->_value._array);
+      if(first.size() != second.size()) {
+        return false;
+      }
+      for(size_t i = 0; i < first.size(); ++i) {
+        stack.push_back(std::make_pair(first[i], second[i]));
+      }
+    } else if(left->_type == kObject) {
+      const std::unordered_map<std::string, Value *> &first =
+        *(left->_value._object);
+      const std::unordered_map<std::string, Value *> &second =
+        *(right->_value._object);
+      if(first.size() != second.size()) {
+        return false;
+      }
+      for(auto it = first.begin(); it != first.end(); ++it) {
+        auto member = second.find(it->first);
+        if(member == second.end()) {
+          return false;
+        }
+        stack.push_back(std::make_pair(it->second, member->second));
+      }
+    }
+  }
+  return true;
+}
+
+bool Value::operator!=(const Value &other) const {
+  return !(*this == other);
+}
+
+// The tree is walked without recursion, like by operator==
+uint64_t Value::GetHash() const {
+  if(_type != kArray && _type != kObject) {
+    return HashScalar();
+  }
+  std::vector<HashFrame> stack(1, HashFrame(*this));
+  while(true) {
+    const Value *child = stack.back().Peek();
+    if(child != nullptr) {
+      if(child->_type == kArray || child->_type == kObject) {
+        stack.push_back(HashFrame(*child));
+      } else {
+        stack.back().Add(child->HashScalar());
+      }
+      continue;
+    }
+    uint64_t hash = stack.back().Finish();
+    stack.pop_back();
+    if(stack.empty()) {
+      return hash;
+    }
+    stack.back().Add(hash);
+  }
+}
+
+/*
+ * The hashes are kept by the container, see TinkerCache.cpp.
+ * A walk first clears kFlagHashed of the ancestors of changed nodes,
+ * then only the nodes without the flag are hashed again. The hashes of
+ * removed nodes are dropped with all the others, once they outnumber
+ * the nodes of the tree. A scalar or borrowed value keeps nothing.
+ */
+uint64_t Value::GetHash() {
+  KeptHashes *kept = GetKeptHashes();
+  if(kept == nullptr) {
+    return static_cast<const Value &>(*this).GetHash();
+  }
+  size_t nodes = 0;
+  FindChanges(kFlagHashed, nodes);
+  if(kept->size() > 2 * nodes) {
+    kept->clear();
+  }
+  return KeepHash(*kept);
+}
+
+/**
+ * Private functions
+ */
+
+// The hash of a scalar, which seeds the hash of a container
+uint64_t Value::HashScalar() const {
+  uint64_t hash = MixHash((uint64_t)_type + 1);
+  if(_type == kNumber) {
+    NumberValue number = NormalizeNumber(ReadNumber());
+    hash = MixHash(hash ^ MixHash(number.kind + 1) ^ number.value.uint64);
+  } else if(_type == kString) {
+    hash = MixHash(hash ^ HashBytes(
+      (_value._string)->data(), (_value._string)->length()));
+  }
+  return hash;
+}
+
+/*
+ * Strings and containers keep their hashes, other scalars are cheaper
+ * to hash again than to look up. Every node gets kFlagHashed, so that
+ * the next walk sees which ones changed. The tree is walked without
+ * recursion.
+ */
+uint64_t Value::KeepHash(KeptHashes &kept) {
+  std::vector<HashFrame> stack;
+  Value *value = this;
+  uint64_t hash = 0;
+  while(true) {
+    bool container = (value->_type == kArray || value->_type == kObject);
+    bool keep = (container || value->_type == kString);
+    auto it = kept.end();
+    if(keep && (value->_flags & kFlagHashed)) {
+      it = kept.find(value);
+    }
+    bool opened = false;
+    if(it != kept.end()) {
+      hash = it->second;
+    } else if(container) {
+      stack.push_back(HashFrame(*value));
+      opened = true;
+    } else {
+      hash = value->HashScalar();
+      if(keep) {
+        kept[value] = hash;
+      }
+    }
+    value->_flags |= kFlagHashed;
+
+    // Finish the containers whose children are all hashed
+    value = nullptr;
+    while(value == nullptr && !stack.empty()) {
+      HashFrame &frame = stack.back();
+      if(!opened) {
+        frame.Add(hash);
+      }
+      opened = false;
+      value = frame.Peek();
+      if(value == nullptr) {
+        hash = frame.Finish();
+        kept[frame.value] = hash;
+        stack.pop_back();
+      }
+    }
+    if(value == nullptr) {
+      return hash;
+    }
+  }
+}
+
+/*
+ * One representation per numeric value: integers, including the
+ * integral doubles in range, as kUint64 when not negative and as kInt64
+ * otherwise, other doubles as kDouble. So 1, 1.0 and 1e0 are equal,
+ * -0 and 0 too, while 2^53 + 1 and 2^53 stay apart.
+ */
+NumberValue Value::NormalizeNumber(const NumberValue &number) {
+  NumberValue normal = number;
+  if(number.kind == NumberValue::kInt64 && number.value.int64 >= 0) {
+    normal.kind = NumberValue::kUint64;
+    normal.value.uint64 = (uint64_t)number.value.int64;
+  } else if(number.kind == NumberValue::kDouble) {
+    double d = number.value.number;
+    if(d == std::floor(d) && d >= -9223372036854775808.0 &&
+      d < 18446744073709551616.0) {
+      if(d < 0) {
+        normal.kind = NumberValue::kInt64;
+        normal.value.int64 = (int64_t)d;
+      } else {
+        normal.kind = NumberValue::kUint64;
+        normal.value.uint64 = (uint64_t)d;
+      }
+    }
+  }
+  return normal;
+}
+}
@@ -19,6 +19,22 @@ enum Type {
   kObject
 };
 
+enum ParseFlag {
+  kParseDefault = 0,
+  // Keep numbers as their source text, converted on first access
+  kParseRawNumbers = 1,
+  // Reject texts which are not valid UTF-8 and lone surrogate escapes
+  kParseValidateUtf8 = 2
+};
+
+enum StringifyFlag {
+  kStringifyDefault = 0,
+  // Escape every character outside ASCII as \uXXXX
+  kStringifyEnsureAscii = 1,
+  // Keep the text, and only write again what changed since the last call
+  kStringifyCached = 2
+};
+
 enum ReturnValue {
   kOk = 0,
   kExpectValue,
@@ -33,9 +49,21 @@ enum ReturnValue {
   kMissCommaOrSquareBracket,
   kMissKey,
   kMissColon,
-  kMissCommaOrCurlyBracket
+  kMissCommaOrCurlyBracket,
+  kDepthLimitExceeded,
+  kTypeMismatch,
+  kInvalidUtf8,
+  kInvalidPatch,
+  kPathNotFound,
+  kPatchTestFailed,
+  kInvalidGzip,
+  kReadFailed,
+  kContextOwned
 };
 
+// Arrays and objects nested deeper than this are rejected
+static const unsigned kDefaultMaxDepth = 1024;
+
 static const char *TypeString[] = {
   "Null",
   "False",
@@ -60,7 +88,16 @@ static const char *StatusString[] = {
   "MissCommaOrSquareBracket",
   "MissKey",
   "MissColon",
-  "MissCommaOrCurlyBracket"
+  "MissCommaOrCurlyBracket",
+  "DepthLimitExceeded",
+  "TypeMismatch",
+  "InvalidUtf8",
+  "InvalidPatch",
+  "PathNotFound",
+  "PatchTestFailed",
+  "InvalidGzip",
+  "ReadFailed",
+  "ContextOwned"
 };
 }
 
@@ -0,0 +1,115 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerContext.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerContext.h"
+#include "source/TinkerValue.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Constructors & Destructors
+ */
+
+ParserContext::ParserContext()
+  : _nodes_used(0),
+    _max_depth(kDefaultMaxDepth) {
+}
+
+/*
+ * The nodes only borrow their payloads from the pools,
+ * so they can be destroyed before the pools.
+ */
+ParserContext::~ParserContext() {
+  for(size_t i = 0; i < _chunks.size(); ++i) {
+    delete[] _chunks[i];
+  }
+}
+
+/**
+ * Public functions
+ */
+
+void ParserContext::Reset() {
+  _nodes_used = 0;
+  _strings.Rewind();
+  _raw_numbers.Rewind();
+  _arrays.Rewind();
+  _objects.Rewind();
+}
+
+void ParserContext::SetMaxDepth(size_t depth) {
+  _max_depth = depth;
+}
+
+size_t ParserContext::GetMaxDepth() const {
+  return _max_depth;
+}
+
+size_t ParserContext::GetNodeCapacity() const {
+  return _chunks.size() * kChunkSize;
+}
+
+size_t ParserContext::GetStringCapacity() const {
+  return _strings.GetCapacity();
+}
+
+size_t ParserContext::GetRawNumberCapacity() const {
+  return _raw_numbers.GetCapacity();
+}
+
+size_t ParserContext::GetArrayCapacity() const {
+  return _arrays.GetCapacity();
+}
+
+size_t ParserContext::GetObjectCapacity() const {
+  return _objects.GetCapacity();
+}
+
+size_t ParserContext::GetStackCapacity() const {
+  return _stack.size();
+}
+
+/**
+ * Private functions
+ */
+
+/*
+ * A reused node may have been modified by the user since it was
+ * handed out, so it is freed before being handed out again.
+ */
+Value* ParserContext::AcquireValue() {
+  size_t chunk = _nodes_used / kChunkSize;
+  if(chunk == _chunks.size()) {
+    _chunks.push_back(new Value[kChunkSize]);
+  }
+  Value *value = &_chunks[chunk][_nodes_used % kChunkSize];
+  _nodes_used++;
+  value->Free();
+  return value;
+}
+
+std::string* ParserContext::AcquireString() {
+  return _strings.Acquire();
+}
+
+RawNumber* ParserContext::AcquireRawNumber() {
+  return _raw_numbers.Acquire();
+}
+
+std::vector<Value *>* ParserContext::AcquireArray() {
+  return _arrays.Acquire();
+}
+
+std::unordered_map<std::string, Value *>* ParserContext::AcquireObject() {
+  return _objects.Acquire();
+}
+}
@@ -0,0 +1,115 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerContext.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_CONTEXT_H
+#define TINKER_JSON_PARSER_TINKER_CONTEXT_H
+
+#include "TinkerConstant.h"
+#include "TinkerValue.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tinker {
+/*
+ * A ParserContext keeps the nodes, strings and containers of the
+ * documents parsed with Value::Parse(json, context) between parses.
+ * Each parse starts with Reset(), which makes everything reusable
+ * instead of freeing it, so parsing a stream of similar messages
+ * allocates almost nothing once the context has warmed up:
+ * strings and arrays keep their capacities, objects keep their buckets.
+ *
+ * A context backs one document at a time, the next parse or Reset()
+ * invalidates the previous document. The values of that document
+ * may be destroyed in any order, but must not be used afterwards.
+ * They are never frozen into a SharedDocument nor patched, those
+ * functions give kContextOwned.
+ * A context must only be used by one thread at a time.
+ *
+ * The context also keeps the stack of the parser,
+ * and the maximum depth of the documents parsed with it.
+ */
+class ParserContext {
+ public:
+  ParserContext();
+  ~ParserContext();
+
+  // Make every object handed out reusable
+  void Reset();
+
+  // Maximum nesting depth of arrays and objects, kDefaultMaxDepth by default
+  void SetMaxDepth(size_t depth);
+  size_t GetMaxDepth() const;
+
+  // Number of objects kept by the context
+  size_t GetNodeCapacity() const;
+  size_t GetStringCapacity() const;
+  size_t GetRawNumberCapacity() const;
+  size_t GetArrayCapacity() const;
+  size_t GetObjectCapacity() const;
+  size_t GetStackCapacity() const;
+
+ private:
+  friend class Value;
+
+  ParserContext(const ParserContext &) = delete;
+  ParserContext& operator=(const ParserContext &) = delete;
+
+  // Objects handed out to the parser, valid until the next Reset()
+  Value* AcquireValue();
+  std::string* AcquireString();
+  RawNumber* AcquireRawNumber();
+  std::vector<Value *>* AcquireArray();
+  std::unordered_map<std::string, Value *>* AcquireObject();
+
+  /*
+   * Objects handed out in order, and cleared when handed out again.
+   */
+  template <typename T>
+  class Pool {
+   public:
+    Pool() : _used(0) {}
+    ~Pool() {
+      for(size_t i = 0; i < _objects.size(); ++i) {
+        delete _objects[i];
+      }
+    }
+    T* Acquire() {
+      if(_used == _objects.size()) {
+        _objects.push_back(new T());
+        return _objects[_used++];
+      }
+      T *object = _objects[_used++];
+      object->clear();
+      return object;
+    }
+    void Rewind() { _used = 0; }
+    size_t GetCapacity() const { return _objects.size(); }
+
+   private:
+    std::vector<T *> _objects;
+    size_t _used;
+  };
+
+  // Nodes are kept in chunks to save one allocation per node
+  static const size_t kChunkSize = 256;
+  std::vector<Value *> _chunks;
+  size_t _nodes_used;
+
+  Pool<std::string> _strings;
+  Pool<RawNumber> _raw_numbers;
+  Pool<std::vector<Value *> > _arrays;
+  Pool<std::unordered_map<std::string, Value *> > _objects;
+
+  // Frames keep their key buffers between parses
+  std::vector<Value::ParseFrame> _stack;
+  size_t _max_depth;
+};
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_CONTEXT_H
@@ -0,0 +1,43 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerCpu.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_CPU_H
+#define TINKER_JSON_PARSER_TINKER_CPU_H
+
+namespace Tinker {
+/*
+ * The instruction sets of the scanning kernels. The widest one the
+ * CPU runs is detected once when the library is loaded, so a single
+ * binary built for the baseline of its architecture uses AVX2 or
+ * AVX-512 where they are available. NEON is the baseline of ARM64.
+ */
+enum SimdLevel {
+  kSimdScalar,
+  kSimdSse2,
+  kSimdAvx2,
+  kSimdAvx512,
+  kSimdNeon
+};
+
+// Names of the levels, indexed by SimdLevel
+extern const char *SimdLevelString[kSimdNeon + 1];
+
+// Whether the CPU and the build can run the kernels of the level
+bool IsSimdLevelSupported(SimdLevel level);
+// The widest supported level, the one used unless another is set
+SimdLevel GetBestSimdLevel();
+SimdLevel GetSimdLevel();
+
+/*
+ * Forces the kernels of a level, e.g. to test or benchmark each one.
+ * Returns false and keeps the current kernels if it is not supported.
+ * Values being parsed on other threads may use either kernels.
+ */
+bool SetSimdLevel(SimdLevel level);
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_CPU_H
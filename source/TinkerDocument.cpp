@@ -0,0 +1,467 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerDocument.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerDocument.h"
+#include "source/TinkerValue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+inline size_t MixHash(size_t seed, size_t hash) {
+  return seed ^ (hash + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+}
+
+/*
+ * Hazard pointers, which make Load() lock-free. A reader announces
+ * the version it is about to copy in the record of its thread, then
+ * checks that the version is still current. A writer only deletes
+ * the version it replaced once no record announces it. The records are
+ * never deleted, the record of a thread which exited is reused.
+ */
+struct HazardRecord {
+  std::atomic<const void *> hazard;
+  std::atomic<bool> active;
+  HazardRecord *next;
+};
+
+static std::atomic<HazardRecord *> gHazardRecords(nullptr);
+
+// Holds the record of its thread until the thread exits
+class HazardOwner {
+ public:
+  HazardOwner() : _record(Acquire()) {
+  }
+  ~HazardOwner() {
+    _record->hazard.store(nullptr);
+    _record->active.store(false);
+  }
+
+  std::atomic<const void *>& GetHazard() {
+    return _record->hazard;
+  }
+
+ private:
+  static HazardRecord* Acquire() {
+    for(HazardRecord *record = gHazardRecords.load();
+      record != nullptr;
+      record = record->next) {
+      bool active = false;
+      if(record->active.compare_exchange_strong(active, true)) {
+        return record;
+      }
+    }
+    HazardRecord *record = new HazardRecord();
+    record->hazard.store(nullptr);
+    record->active.store(true);
+    record->next = gHazardRecords.load();
+    while(!gHazardRecords.compare_exchange_weak(record->next, record)) {
+    }
+    return record;
+  }
+
+  HazardRecord *_record;
+};
+
+// A published snapshot, deleted once replaced and announced by no reader
+struct SharedDocument::Version {
+  explicit Version(const Snapshot &snapshot) : snapshot(snapshot) {
+  }
+
+  const Snapshot snapshot;
+};
+
+/*
+ * A deduplicated tree: the nodes with several parents are owned here.
+ * Their parents skip them, which reads their flags, so every tree
+ * is emptied before any shared node is deleted.
+ */
+struct SharedDocument::DedupTree {
+  ~DedupTree() {
+    root.Free();
+    for(size_t i = 0; i < shared.size(); ++i) {
+      shared[i]->Free();
+    }
+    for(size_t i = 0; i < shared.size(); ++i) {
+      delete shared[i];
+    }
+  }
+
+  Value root;
+  std::vector<Value *> shared;
+};
+
+/**
+ * Constructors & Destructors
+ */
+
+DedupStats::DedupStats() {
+  removed_nodes = 0;
+  shared_nodes = 0;
+  bytes_before = 0;
+  bytes_after = 0;
+}
+
+SharedDocument::SharedDocument()
+  : _current(new Version(std::make_shared<const Value>())) {
+}
+
+// No reader may be in Load() any more
+SharedDocument::~SharedDocument() {
+  delete _current.load();
+}
+
+/**
+ * Snapshot functions
+ */
+
+/*
+ * Raw numbers cache their value on first access,
+ * so they are all converted before the tree is shared.
+ * A text cache of the tree is dropped, a const tree never uses it.
+ * A deduplicated snapshot points into the DedupTree which owns it.
+ */
+ReturnValue SharedDocument::Freeze(
+  Value &value,
+  Snapshot &snapshot,
+  unsigned flags,
+  DedupStats *stats) {
+  if(IsContextOwned(value)) {
+    return kContextOwned;
+  }
+  if(!(flags & kFreezeDeduplicate)) {
+    std::shared_ptr<Value> root = std::make_shared<Value>();
+    root->Swap(value);
+    root->DropCache();
+    root->ConvertRawNumbers();
+    snapshot = root;
+    return kOk;
+  }
+  std::shared_ptr<DedupTree> tree = std::make_shared<DedupTree>();
+  tree->root.Swap(value);
+  tree->root.DropCache();
+  tree->root.ConvertRawNumbers();
+  DedupStats result;
+  result.bytes_before = tree->root.GetMemoryStats().total_bytes;
+  Deduplicate(tree->root, tree->shared, result);
+  result.bytes_after = tree->root.GetMemoryStats().total_bytes;
+  if(stats != nullptr) {
+    *stats = result;
+  }
+  snapshot = Snapshot(tree, &tree->root);
+  return kOk;
+}
+
+// A tree parsed with a ParserContext has a borrowed root
+bool SharedDocument::IsContextOwned(const Value &value) {
+  return (value._flags & Value::kFlagBorrowed) != 0;
+}
+
+/*
+ * The version is announced before it is read, and only read if it
+ * was still current once announced: a writer which replaced it since
+ * then sees the announcement and waits. Copying the snapshot only
+ * increments its reference count, which is atomic without a lock.
+ */
+SharedDocument::Snapshot SharedDocument::Load() const {
+  static thread_local HazardOwner owner;
+  std::atomic<const void *> &hazard = owner.GetHazard();
+  Version *version = _current.load();
+  while(true) {
+    hazard.store(version);
+    Version *current = _current.load();
+    if(current == version) {
+      break;
+    }
+    version = current;
+  }
+  Snapshot snapshot = version->snapshot;
+  hazard.store(nullptr);
+  return snapshot;
+}
+
+void SharedDocument::Store(Snapshot snapshot) {
+  Exchange(snapshot);
+}
+
+ReturnValue SharedDocument::Publish(Value &value, unsigned flags) {
+  Snapshot snapshot;
+  ReturnValue result = Freeze(value, snapshot, flags);
+  if(result == kOk) {
+    Store(snapshot);
+  }
+  return result;
+}
+
+/*
+ * The new version is parsed aside and only published on success,
+ * a failed parse leaves the current version untouched.
+ */
+ReturnValue SharedDocument::Parse(const char *json, unsigned flags) {
+  Value value;
+  ReturnValue result = value.Parse(json, flags);
+  if(result == kOk) {
+    result = Publish(value);
+  }
+  return result;
+}
+
+/*
+ * The previous version is deleted once the lock is released and no
+ * reader announces it any more, so its tree is freed by this call
+ * whenever no snapshot of it is left. A reader only announces a version
+ * while it copies its snapshot, so the wait is short.
+ */
+SharedDocument::Snapshot SharedDocument::Exchange(Snapshot snapshot) {
+  Version *version = new Version(snapshot);
+  Version *retired;
+  {
+    std::lock_guard<std::mutex> lock(_writer);
+    retired = _current.exchange(version);
+  }
+  Snapshot previous = retired->snapshot;
+  WaitForReaders(retired);
+  delete retired;
+  return previous;
+}
+
+// Returns once no hazard record announces the version
+void SharedDocument::WaitForReaders(const Version *version) {
+  HazardRecord *record = gHazardRecords.load();
+  while(record != nullptr) {
+    if(record->hazard.load() == version) {
+      std::this_thread::yield();
+    } else {
+      record = record->next;
+    }
+  }
+}
+
+/**
+ * Deduplication
+ */
+
+struct SharedDocument::DedupNode {
+  size_t hash;
+  size_t references;
+};
+
+/*
+ * Hash-consing, bottom-up without recursion. When a container is
+ * complete its children are replaced by their first occurrence,
+ * so two identical subtrees always end up with the very same
+ * children, and comparing two containers is a shallow comparison.
+ * A duplicate is deleted once its children are detached from it.
+ * Finally the nodes referenced from several places are flagged,
+ * the parents do not free them and the frozen tree owns them.
+ */
+void SharedDocument::Deduplicate(
+  Value &root,
+  std::vector<Value *> &shared,
+  DedupStats &stats) {
+  DedupTable nodes;
+  std::unordered_multimap<size_t, Value *> candidates;
+  std::vector<std::pair<Value *, bool> > stack;
+  stack.push_back(std::make_pair(&root, false));
+  while(!stack.empty()) {
+    Value *value = stack.back().first;
+    bool complete = stack.back().second;
+    if(!complete) {
+      stack.back().second = true;
+      if(value->_type == kArray) {
+        std::vector<Value *> &array = *(value->_value._array);
+        for(size_t i = 0; i < array.size(); ++i) {
+          if(array[i]->_type == kArray || array[i]->_type == kObject) {
+            stack.push_back(std::make_pair(array[i], false));
+          }
+        }
+      } else if(value->_type == kObject) {
+        for(auto it = (value->_value._object)->begin();
+          it != (value->_value._object)->end();
+          ++it) {
+          if(it->second->_type == kArray || it->second->_type == kObject) {
+            stack.push_back(std::make_pair(it->second, false));
+          }
+        }
+      }
+      continue;
+    }
+    stack.pop_back();
+    if(value->_type == kArray) {
+      std::vector<Value *> &array = *(value->_value._array);
+      for(size_t i = 0; i < array.size(); ++i) {
+        array[i] = Intern(array[i], nodes, candidates, stats);
+      }
+    } else if(value->_type == kObject) {
+      for(auto it = (value->_value._object)->begin();
+        it != (value->_value._object)->end();
+        ++it) {
+        it->second = Intern(it->second, nodes, candidates, stats);
+      }
+    }
+  }
+
+  for(auto it = nodes.begin(); it != nodes.end(); ++it) {
+    if(it->second.references > 1) {
+      Value *value = const_cast<Value *>(it->first);
+      value->_flags |= Value::kFlagShared;
+      shared.push_back(value);
+    }
+  }
+  stats.shared_nodes = shared.size();
+}
+
+/*
+ * Returns the first occurrence of a node whose children are
+ * already interned, and deletes the node if it is a duplicate.
+ */
+Value* SharedDocument::Intern(
+  Value *value,
+  DedupTable &nodes,
+  std::unordered_multimap<size_t, Value *> &candidates,
+  DedupStats &stats) {
+  size_t hash = HashNode(*value, nodes);
+  auto range = candidates.equal_range(hash);
+  for(auto it = range.first; it != range.second; ++it) {
+    if(!IsSameNode(*value, *(it->second))) {
+      continue;
+    }
+    nodes[it->second].references++;
+    // The children now have one parent less
+    if(value->_type == kArray) {
+      std::vector<Value *> &array = *(value->_value._array);
+      for(size_t i = 0; i < array.size(); ++i) {
+        auto node = nodes.find(array[i]);
+        if(node != nodes.end()) node->second.references--;
+      }
+      array.clear();
+    } else if(value->_type == kObject) {
+      for(auto child = (value->_value._object)->begin();
+        child != (value->_value._object)->end();
+        ++child) {
+        auto node = nodes.find(child->second);
+        if(node != nodes.end()) node->second.references--;
+      }
+      (value->_value._object)->clear();
+    }
+    delete value;
+    stats.removed_nodes++;
+    return it->second;
+  }
+  DedupNode node = {hash, 1};
+  nodes[value] = node;
+  candidates.insert(std::make_pair(hash, value));
+  return value;
+}
+
+/*
+ * Children are hashed through their interned nodes. The members
+ * of an object are combined in an order-insensitive way,
+ * since equal objects may iterate in different orders.
+ */
+size_t SharedDocument::HashNode(const Value &value, const DedupTable &nodes) {
+  std::hash<std::string> hash_string;
+  size_t hash = std::hash<int>()(value._type);
+  switch(value._type) {
+    case kNumber: {
+      if(value._flags & Value::kFlagRawNumber) {
+        return MixHash(hash, hash_string((value._value._raw)->text));
+      }
+      uint64_t bits;
+      memcpy(&bits, &value._value, sizeof(bits));
+      hash = MixHash(hash, value._flags & Value::kPayloadFlags);
+      return MixHash(hash, std::hash<uint64_t>()(bits));
+    }
+    case kString: {
+      return MixHash(hash, hash_string(*(value._value._string)));
+    }
+    case kArray: {
+      const std::vector<Value *> &array = *(value._value._array);
+      for(size_t i = 0; i < array.size(); ++i) {
+        auto node = nodes.find(array[i]);
+        hash = MixHash(hash, node == nodes.end() ?
+          std::hash<const Value *>()(array[i]) : node->second.hash);
+      }
+      return hash;
+    }
+    case kObject: {
+      size_t members = 0;
+      for(auto it = (value._value._object)->begin();
+        it != (value._value._object)->end();
+        ++it) {
+        auto node = nodes.find(it->second);
+        members += MixHash(hash_string(it->first), node == nodes.end() ?
+          std::hash<const Value *>()(it->second) : node->second.hash);
+      }
+      return MixHash(hash, members);
+    }
+    default: {
+      return hash;
+    }
+  }
+}
+
+bool SharedDocument::IsSameNode(const Value &lhs, const Value &rhs) {
+  if(lhs._type != rhs._type) {
+    return false;
+  }
+  switch(lhs._type) {
+    case kNumber: {
+      unsigned flags = Value::kFlagInt64 | Value::kFlagUint64 |
+        Value::kFlagRawNumber;
+      if((lhs._flags & flags) != (rhs._flags & flags)) {
+        return false;
+      }
+      if(lhs._flags & Value::kFlagRawNumber) {
+        return (lhs._value._raw)->text == (rhs._value._raw)->text;
+      }
+      // Bitwise, so -0 and 0 stay apart
+      return memcmp(&lhs._value, &rhs._value, sizeof(lhs._value)) == 0;
+    }
+    case kString: {
+      return *(lhs._value._string) == *(rhs._value._string);
+    }
+    case kArray: {
+      return *(lhs._value._array) == *(rhs._value._array);
+    }
+    case kObject: {
+      const std::unordered_map<std::string, Value *> &left =
+        *(lhs._value._object);
+      const std::unordered_map<std::string, Value *> &right =
+        *(rhs._value._object);
+      if(left.size() != right.size()) {
+        return false;
+      }
+      for(auto it = left.begin(); it != left.end(); ++it) {
+        auto other = right.find(it->first);
+        if(other == right.end() || other->second != it->second) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default: {
+      return true;
+    }
+  }
+}
+}
@@ -0,0 +1,123 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerDocument.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_DOCUMENT_H
+#define TINKER_JSON_PARSER_TINKER_DOCUMENT_H
+
+#include "TinkerConstant.h"
+#include "TinkerValue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Tinker {
+// Options of SharedDocument::Freeze() and Publish()
+enum FreezeFlag {
+  kFreezeDefault = 0,
+  // Share the identical subtrees of the tree between their parents
+  kFreezeDeduplicate = 1
+};
+
+/*
+ * What kFreezeDeduplicate saved. The bytes are measured as
+ * Value::GetMemoryStats() does, shared nodes being counted once.
+ */
+struct DedupStats {
+  DedupStats();
+
+  size_t removed_nodes;  // Duplicates deleted
+  size_t shared_nodes;   // Nodes left with several parents
+  size_t bytes_before;
+  size_t bytes_after;
+};
+
+/*
+ * A SharedDocument publishes immutable Value trees to many threads.
+ *
+ * A published tree is frozen: it is only reachable through
+ * const references, the getters of a const Value only return const
+ * references, and its raw numbers are converted when it is frozen.
+ * None of the const member functions of Value write to the tree,
+ * so any number of threads may call them on a snapshot concurrently
+ * without locking.
+ * Snapshots are reference counted, a tree is destroyed when the last
+ * reader releases it. Publishing a new version swaps the current
+ * snapshot atomically, readers holding the old one keep using it.
+ * Load() is lock-free: readers never wait for each other nor for a
+ * writer. Writers are serialized by a mutex, and wait for the readers
+ * still copying the snapshot they replace, which only takes a moment.
+ *
+ * Since a frozen tree is never modified, identical subtrees may be
+ * stored once: with kFreezeDeduplicate every subtree, string or
+ * scalar which occurs several times is shared by all its parents,
+ * which suits large reference documents kept for a long time.
+ * Equal objects are shared whatever the order of their members,
+ * so they all stringify in the order of the first one.
+ *
+ * A tree parsed with a ParserContext is reused by the next parse,
+ * so it is never frozen: Freeze() and Publish() give kContextOwned
+ * for it and leave it in place.
+ */
+class SharedDocument {
+ public:
+  typedef std::shared_ptr<const Value> Snapshot;
+
+  SharedDocument();
+  ~SharedDocument();
+
+  SharedDocument(const SharedDocument &) = delete;
+  SharedDocument& operator=(const SharedDocument &) = delete;
+
+  // Take over the tree of value, leaving it null, and freeze it
+  static ReturnValue Freeze(
+    Value &value,
+    Snapshot &snapshot,
+    unsigned flags = kFreezeDefault,
+    DedupStats *stats = nullptr);
+
+  // Get the current version, safe to call from any thread
+  Snapshot Load() const;
+
+  // Publish a new version, safe to call from any thread
+  void Store(Snapshot snapshot);
+  ReturnValue Publish(Value &value, unsigned flags = kFreezeDefault);
+  ReturnValue Parse(const char *json, unsigned flags = kParseDefault);
+
+  // Publish a new version and return the previous one
+  Snapshot Exchange(Snapshot snapshot);
+
+ private:
+  struct Version;
+  struct DedupTree;
+  struct DedupNode;
+  typedef std::unordered_map<const Value *, DedupNode> DedupTable;
+
+  static bool IsContextOwned(const Value &value);
+  static void Deduplicate(
+    Value &root,
+    std::vector<Value *> &shared,
+    DedupStats &stats);
+  static Value* Intern(
+    Value *value,
+    DedupTable &nodes,
+    std::unordered_multimap<size_t, Value *> &candidates,
+    DedupStats &stats);
+  static size_t HashNode(const Value &value, const DedupTable &nodes);
+  static bool IsSameNode(const Value &lhs, const Value &rhs);
+
+  static void WaitForReaders(const Version *version);
+
+  std::atomic<Version *> _current;
+  std::mutex _writer;
+};
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_DOCUMENT_H
@@ -0,0 +1,295 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerGzip.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerGzip.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+// Compressed bytes read at a time
+static const size_t kInputSize = 64 * 1024;
+// Decompressed chunks of the background thread, and how many wait
+static const size_t kChunkSize = 256 * 1024;
+static const size_t kQueueChunks = 4;
+
+/**
+ * Inflater
+ */
+
+/*
+ * The zlib stream and its source. Inflate() runs on the thread of the
+ * reader, or on the background thread, which fills a ring of chunks:
+ * _filled chunks from _head are ready, the reader holds the first one
+ * until it has copied it out, the thread fills the others.
+ */
+class Inflater {
+ public:
+  Inflater(const GzipReader::ReadFunction &read, FILE *file, bool opened);
+  ~Inflater();
+
+  void Start(bool background);
+  size_t Read(char *buffer, size_t size);
+  ReturnValue GetResult();
+
+ private:
+  size_t Inflate(char *buffer, size_t size);
+  void Run();
+
+  GzipReader::ReadFunction _read;
+  FILE *_file;
+  z_stream _stream;
+  bool _initialized;
+  std::vector<char> _input;
+  bool _input_end;
+  bool _member_end;
+  bool _done;
+  ReturnValue _status;   // Of Inflate(), on its thread
+
+  bool _background;
+  std::thread _thread;
+  std::mutex _mutex;
+  std::condition_variable _ready;
+  std::condition_variable _free;
+  std::vector<std::vector<char> > _chunks;
+  std::vector<size_t> _sizes;
+  size_t _head;
+  size_t _filled;
+  size_t _position;      // In the chunk at _head, while _holding
+  bool _holding;
+  bool _finished;
+  bool _stopping;
+  ReturnValue _result;   // _status once the thread finished
+};
+
+Inflater::Inflater(
+  const GzipReader::ReadFunction &read,
+  FILE *file,
+  bool opened)
+  : _read(read),
+    _file(file),
+    _initialized(false),
+    _input(kInputSize),
+    _input_end(false),
+    _member_end(false),
+    _done(false),
+    _status(kOk),
+    _background(false),
+    _head(0),
+    _filled(0),
+    _position(0),
+    _holding(false),
+    _finished(false),
+    _stopping(false),
+    _result(kOk) {
+  memset(&_stream, 0, sizeof(_stream));
+  if(!opened) {
+    _status = kReadFailed;
+    return;
+  }
+  // 15 + 32: the largest window, with a gzip or zlib header
+  if(inflateInit2(&_stream, 15 + 32) != Z_OK) {
+    _status = kInvalidGzip;
+    return;
+  }
+  _initialized = true;
+}
+
+Inflater::~Inflater() {
+  if(_thread.joinable()) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _stopping = true;
+    lock.unlock();
+    _free.notify_all();
+    _thread.join();
+  }
+  if(_initialized) {
+    inflateEnd(&_stream);
+  }
+  if(_file != nullptr) {
+    fclose(_file);
+  }
+}
+
+void Inflater::Start(bool background) {
+  _background = background;
+  if(background) {
+    _chunks.assign(kQueueChunks, std::vector<char>(kChunkSize));
+    _sizes.assign(kQueueChunks, 0);
+    _thread = std::thread(&Inflater::Run, this);
+  }
+}
+
+/*
+ * Fills the buffer unless the data ends or is invalid. A member which
+ * ends is followed by another one, or by the end of the input.
+ */
+size_t Inflater::Inflate(char *buffer, size_t size) {
+  size_t produced = 0;
+  while(produced < size && _status == kOk && !_done) {
+    if(_stream.avail_in == 0 && !_input_end) {
+      size_t count;
+      if(_file != nullptr) {
+        count = fread(_input.data(), 1, _input.size(), _file);
+        if(count == 0 && ferror(_file)) {
+          _status = kReadFailed;
+          break;
+        }
+      } else {
+        count = _read(_input.data(), _input.size());
+      }
+      _input_end = (count == 0);
+      _stream.next_in = (Bytef *)_input.data();
+      _stream.avail_in = (uInt)count;
+    }
+    if(_member_end) {
+      if(_stream.avail_in == 0) {
+        _done = _input_end;
+        continue;
+      }
+      inflateReset(&_stream);
+      _member_end = false;
+    }
+    _stream.next_out = (Bytef *)(buffer + produced);
+    _stream.avail_out = (uInt)(size - produced);
+    int code = inflate(&_stream, Z_NO_FLUSH);
+    produced = size - _stream.avail_out;
+    if(code == Z_STREAM_END) {
+      _member_end = true;
+    } else if(code == Z_BUF_ERROR) {
+      // No progress without more input, a cut stream if there is none
+      if(_input_end && _stream.avail_in == 0) {
+        _status = kInvalidGzip;
+      }
+    } else if(code != Z_OK) {
+      _status = kInvalidGzip;
+    }
+  }
+  return produced;
+}
+
+/*
+ * Decompresses whole chunks ahead of the reader. A chunk which is
+ * not full is the last one.
+ */
+void Inflater::Run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while(true) {
+    _free.wait(lock, [this]() {
+      return _stopping || _filled < kQueueChunks;
+    });
+    if(_stopping) {
+      return;
+    }
+    size_t slot = (_head + _filled) % kQueueChunks;
+    lock.unlock();
+    size_t size = Inflate(_chunks[slot].data(), kChunkSize);
+    lock.lock();
+    _sizes[slot] = size;
+    if(size > 0) {
+      ++_filled;
+    }
+    if(size < kChunkSize) {
+      _finished = true;
+      _result = _status;
+    }
+    _ready.notify_one();
+    if(_finished) {
+      return;
+    }
+  }
+}
+
+size_t Inflater::Read(char *buffer, size_t size) {
+  if(!_background) {
+    return Inflate(buffer, size);
+  }
+  size_t copied = 0;
+  while(copied < size) {
+    if(_holding && _position == _sizes[_head]) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _head = (_head + 1) % kQueueChunks;
+      --_filled;
+      _holding = false;
+      _free.notify_one();
+    }
+    if(!_holding) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _ready.wait(lock, [this]() { return _filled > 0 || _finished; });
+      if(_filled == 0) {
+        break;
+      }
+      _holding = true;
+      _position = 0;
+    }
+    size_t count = std::min(size - copied, _sizes[_head] - _position);
+    memcpy(buffer + copied, _chunks[_head].data() + _position, count);
+    _position += count;
+    copied += count;
+  }
+  return copied;
+}
+
+ReturnValue Inflater::GetResult() {
+  if(!_background) {
+    return _status;
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _result;
+}
+
+/**
+ * Gzip reader
+ */
+
+GzipReader::GzipReader(const char *path, bool background)
+  : _inflater(nullptr), _offset(0) {
+  FILE *file = fopen(path, "rb");
+  _inflater = new Inflater(ReadFunction(), file, file != nullptr);
+  _inflater->Start(background);
+}
+
+GzipReader::GzipReader(const ReadFunction &read, bool background)
+  : _inflater(new Inflater(read, nullptr, true)), _offset(0) {
+  _inflater->Start(background);
+}
+
+GzipReader::~GzipReader() {
+  delete _inflater;
+}
+
+size_t GzipReader::Read(char *buffer, size_t size) {
+  size_t count = _inflater->Read(buffer, size);
+  _offset += count;
+  return count;
+}
+
+ArrayReader::ReadFunction GzipReader::GetReadFunction() {
+  return [this](char *buffer, size_t size) { return Read(buffer, size); };
+}
+
+ReturnValue GzipReader::GetResult() const {
+  return _inflater->GetResult();
+}
+
+uint64_t GzipReader::GetOffset() const {
+  return _offset;
+}
+}
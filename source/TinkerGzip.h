@@ -0,0 +1,68 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerGzip.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_GZIP_H
+#define TINKER_JSON_PARSER_TINKER_GZIP_H
+
+#include "TinkerConstant.h"
+#include "TinkerStream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace Tinker {
+class Inflater;
+
+/*
+ * A GzipReader decompresses gzip or zlib data in chunks of bounded
+ * size, to feed an ArrayReader or any other reader of chunks, so a
+ * compressed dump is scanned without ever being whole in memory.
+ * Concatenated gzip members, as written by pigz or by cat, are read
+ * one after the other. It needs zlib, and is only built with it.
+ *
+ * With background set, a thread decompresses the next chunks while
+ * the previous ones are parsed, at most a few of them ahead. Either
+ * way the memory used is a few chunks and the zlib window.
+ *
+ * Read() returns 0 at the end of the data and on an error, which
+ * GetResult() tells apart: kReadFailed if the file or the source
+ * could not be read, kInvalidGzip if the data is corrupt or cut.
+ *
+ *   GzipReader gzip("dump.json.gz");
+ *   ArrayReader reader(gzip.GetReadFunction(), "/items");
+ *   for(Value &item : reader) { ... }
+ *   if(gzip.GetResult() != kOk) { ... }
+ *   else if(reader.GetResult() != kOk) { ... }
+ */
+class GzipReader {
+ public:
+  // Fills a buffer with compressed bytes like fread(), 0 at the end
+  typedef std::function<size_t(char *buffer, size_t size)> ReadFunction;
+
+  explicit GzipReader(const char *path, bool background = true);
+  explicit GzipReader(const ReadFunction &read, bool background = true);
+  ~GzipReader();
+
+  GzipReader(const GzipReader &) = delete;
+  GzipReader& operator=(const GzipReader &) = delete;
+
+  // Fills buffer with decompressed bytes like fread()
+  size_t Read(char *buffer, size_t size);
+  // Read() of this reader, which must outlive the function
+  ArrayReader::ReadFunction GetReadFunction();
+  ReturnValue GetResult() const;
+  // Decompressed bytes returned by Read() so far
+  uint64_t GetOffset() const;
+
+ private:
+  Inflater *_inflater;
+  uint64_t _offset;
+};
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_GZIP_H
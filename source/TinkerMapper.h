@@ -0,0 +1,473 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerMapper.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_MAPPER_H
+#define TINKER_JSON_PARSER_TINKER_MAPPER_H
+
+#include "TinkerConstant.h"
+#include "TinkerStream.h"
+#include "TinkerValue.h"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Maps C++ structs to JSON objects without building a tree.
+ * The fields of a struct are declared once, next to the struct
+ * and in the same namespace, at most 32 of them:
+ *
+ *   struct User {
+ *     std::string name;
+ *     int64_t id;
+ *     std::vector<std::string> tags;
+ *   };
+ *   TINKER_JSON_FIELDS(User, name, id, tags)
+ *
+ *   User user;
+ *   ReturnValue result = Tinker::Parse(json, user);
+ *   Tinker::Stringify(user, text);
+ *
+ * Reading dispatches on the hash of the key, with a switch whose
+ * labels are the hashes of the field names computed at compile time,
+ * and skips unknown members. Fields missing from the text keep their
+ * values, a repeated member is assigned twice. Writing appends the
+ * keys as string literals escaped at compile time.
+ *
+ * Supported field types are bool, the integer types, float, double,
+ * std::string, Value, mapped structs, and std::vector, std::map
+ * and std::unordered_map with std::string keys of all of those.
+ * An integer out of the range of its field gives kNumberTooBig,
+ * a value of the wrong type gives kTypeMismatch.
+ */
+
+namespace Tinker {
+/**
+ * Key hashing, FNV-1a
+ */
+
+constexpr uint32_t HashKeyLiteral(
+  const char *key,
+  uint32_t hash = 2166136261u) {
+  return (*key == '\0' ? hash :
+    HashKeyLiteral(key + 1, (hash ^ (unsigned char)*key) * 16777619u));
+}
+
+inline uint32_t HashKey(const std::string &key) {
+  uint32_t hash = 2166136261u;
+  for(size_t i = 0; i < key.length(); ++i) {
+    hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * Readers
+ */
+
+inline ReturnValue ReadJson(Reader &reader, bool &value) {
+  return reader.ReadBoolean(value);
+}
+
+template <typename T>
+ReturnValue ReadInteger(Reader &reader, T &value) {
+  NumberValue number;
+  ReturnValue result = reader.ReadNumber(number);
+  if(result != kOk) {
+    return result;
+  }
+  if(number.kind == NumberValue::kDouble) {
+    return kTypeMismatch;
+  } else if(number.kind == NumberValue::kUint64) {
+    if(number.value.uint64 >
+      (uint64_t)std::numeric_limits<T>::max()) {
+      return kNumberTooBig;
+    }
+    value = (T)number.value.uint64;
+  } else {
+    int64_t int64 = number.value.int64;
+    if(int64 < 0 ?
+      int64 < (int64_t)std::numeric_limits<T>::min() :
+      (uint64_t)int64 > (uint64_t)std::numeric_limits<T>::max()) {
+      return kNumberTooBig;
+    }
+    value = (T)int64;
+  }
+  return kOk;
+}
+
+inline ReturnValue ReadJson(Reader &reader, short &value) {
+  return ReadInteger(reader, value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, unsigned short &value) {
+  return ReadInteger(reader, value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, int &value) {
+  return ReadInteger(reader, value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, unsigned &value) {
+  return ReadInteger(reader, value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, long &value) {
+  return ReadInteger(reader, value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, unsigned long &value) {
+  return ReadInteger(reader, value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, long long &value) {
+  return ReadInteger(reader, value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, unsigned long long &value) {
+  return ReadInteger(reader, value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, double &value) {
+  NumberValue number;
+  ReturnValue result = reader.ReadNumber(number);
+  if(result == kOk) {
+    value = (number.kind == NumberValue::kInt64 ? (double)number.value.int64 :
+      number.kind == NumberValue::kUint64 ? (double)number.value.uint64 :
+      number.value.number);
+  }
+  return result;
+}
+
+inline ReturnValue ReadJson(Reader &reader, float &value) {
+  double number;
+  ReturnValue result = ReadJson(reader, number);
+  if(result == kOk) {
+    value = (float)number;
+  }
+  return result;
+}
+
+inline ReturnValue ReadJson(Reader &reader, std::string &value) {
+  return reader.ReadString(value);
+}
+
+inline ReturnValue ReadJson(Reader &reader, Value &value) {
+  return reader.ReadValue(value);
+}
+
+template <typename T, typename Allocator>
+ReturnValue ReadJson(Reader &reader, std::vector<T, Allocator> &value) {
+  ReturnValue result = reader.StartArray();
+  value.clear();
+  bool more = true;
+  while(result == kOk && (result = reader.NextElement(more)) == kOk && more) {
+    // Read into a local, std::vector<bool> has no bool& to its elements
+    T element = T();
+    if((result = ReadJson(reader, element)) == kOk) {
+      value.push_back(std::move(element));
+    }
+  }
+  return result;
+}
+
+template <typename Map>
+ReturnValue ReadMap(Reader &reader, Map &value) {
+  ReturnValue result = reader.StartObject();
+  value.clear();
+  bool more = true;
+  while(result == kOk && (result = reader.NextMember(more)) == kOk && more) {
+    result = ReadJson(reader, value[reader.GetKey()]);
+  }
+  return result;
+}
+
+template <typename T, typename Compare, typename Allocator>
+ReturnValue ReadJson(
+  Reader &reader,
+  std::map<std::string, T, Compare, Allocator> &value) {
+  return ReadMap(reader, value);
+}
+
+template <typename T, typename Hash, typename Equal, typename Allocator>
+ReturnValue ReadJson(
+  Reader &reader,
+  std::unordered_map<std::string, T, Hash, Equal, Allocator> &value) {
+  return ReadMap(reader, value);
+}
+
+/*
+ * Mapped structs, TinkerReadMember() is found by argument dependent
+ * lookup in the namespace of the struct.
+ */
+template <typename T>
+ReturnValue ReadJson(Reader &reader, T &object) {
+  ReturnValue result = reader.StartObject();
+  bool more = true;
+  while(result == kOk && (result = reader.NextMember(more)) == kOk && more) {
+    result = TinkerReadMember(reader, object, reader.GetKey());
+  }
+  return result;
+}
+
+/**
+ * Writers
+ */
+
+inline void WriteJson(Writer &writer, bool value) {
+  writer.Boolean(value);
+}
+
+inline void WriteJson(Writer &writer, short value) {
+  writer.Int64(value);
+}
+
+inline void WriteJson(Writer &writer, unsigned short value) {
+  writer.Uint64(value);
+}
+
+inline void WriteJson(Writer &writer, int value) {
+  writer.Int64(value);
+}
+
+inline void WriteJson(Writer &writer, unsigned value) {
+  writer.Uint64(value);
+}
+
+inline void WriteJson(Writer &writer, long value) {
+  writer.Int64(value);
+}
+
+inline void WriteJson(Writer &writer, unsigned long value) {
+  writer.Uint64(value);
+}
+
+inline void WriteJson(Writer &writer, long long value) {
+  writer.Int64(value);
+}
+
+inline void WriteJson(Writer &writer, unsigned long long value) {
+  writer.Uint64(value);
+}
+
+inline void WriteJson(Writer &writer, double value) {
+  writer.Double(value);
+}
+
+inline void WriteJson(Writer &writer, float value) {
+  writer.Double(value);
+}
+
+inline void WriteJson(Writer &writer, const std::string &value) {
+  writer.String(value);
+}
+
+inline void WriteJson(Writer &writer, const Value &value) {
+  value.Stringify(writer.GetText(), writer.GetFlags());
+}
+
+template <typename T, typename Allocator>
+void WriteJson(Writer &writer, const std::vector<T, Allocator> &value) {
+  writer.Raw('[');
+  for(size_t i = 0; i < value.size(); ++i) {
+    if(i > 0) {
+      writer.Raw(',');
+    }
+    WriteJson(writer, value[i]);
+  }
+  writer.Raw(']');
+}
+
+template <typename Map>
+void WriteMap(Writer &writer, const Map &value) {
+  writer.Raw('{');
+  for(auto it = value.begin(); it != value.end(); ++it) {
+    if(it != value.begin()) {
+      writer.Raw(',');
+    }
+    writer.String(it->first);
+    writer.Raw(':');
+    WriteJson(writer, it->second);
+  }
+  writer.Raw('}');
+}
+
+template <typename T, typename Compare, typename Allocator>
+void WriteJson(
+  Writer &writer,
+  const std::map<std::string, T, Compare, Allocator> &value) {
+  WriteMap(writer, value);
+}
+
+template <typename T, typename Hash, typename Equal, typename Allocator>
+void WriteJson(
+  Writer &writer,
+  const std::unordered_map<std::string, T, Hash, Equal, Allocator> &value) {
+  WriteMap(writer, value);
+}
+
+template <typename T>
+void WriteJson(Writer &writer, const T &object) {
+  writer.Raw('{');
+  TinkerWriteMembers(writer, object);
+  writer.Raw('}');
+}
+
+/**
+ * Entry points
+ */
+
+template <typename T>
+ReturnValue Parse(const char *json, T &object) {
+  Reader reader(json);
+  ReturnValue result = ReadJson(reader, object);
+  if(result == kOk) {
+    result = reader.Finish();
+  }
+  return result;
+}
+
+template <typename T>
+ReturnValue Stringify(
+  const T &object,
+  std::string &text,
+  unsigned flags = kStringifyDefault) {
+  Writer writer(text, flags);
+  WriteJson(writer, object);
+  return kOk;
+}
+}
+
+/**
+ * Field list macros
+ */
+
+#define TINKER_EXPAND(x) x
+#define TINKER_CONCAT(a, b) TINKER_CONCAT_IMPL(a, b)
+#define TINKER_CONCAT_IMPL(a, b) a##b
+#define TINKER_COUNT(...) \
+  TINKER_EXPAND(TINKER_COUNT_N(__VA_ARGS__, \
+    32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, \
+    16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define TINKER_COUNT_N( \
+  _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, \
+  _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, \
+  _31, _32, \
+  N, ...) N
+#define TINKER_FOR_EACH_1(macro, x) macro(x)
+#define TINKER_FOR_EACH_2(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_1(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_3(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_2(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_4(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_3(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_5(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_4(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_6(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_5(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_7(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_6(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_8(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_7(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_9(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_8(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_10(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_9(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_11(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_10(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_12(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_11(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_13(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_12(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_14(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_13(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_15(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_14(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_16(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_15(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_17(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_16(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_18(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_17(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_19(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_18(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_20(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_19(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_21(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_20(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_22(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_21(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_23(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_22(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_24(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_23(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_25(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_24(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_26(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_25(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_27(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_26(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_28(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_27(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_29(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_28(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_30(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_29(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_31(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_30(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH_32(macro, x, ...) \
+  macro(x) TINKER_EXPAND(TINKER_FOR_EACH_31(macro, __VA_ARGS__))
+#define TINKER_FOR_EACH(macro, ...) \
+  TINKER_EXPAND(TINKER_CONCAT(TINKER_FOR_EACH_, TINKER_COUNT(__VA_ARGS__)) \
+    (macro, __VA_ARGS__))
+
+/*
+ * A hash collision between two fields of a struct is a duplicate
+ * case label, so it is reported by the compiler.
+ */
+#define TINKER_READ_FIELD(field) \
+  case ::Tinker::HashKeyLiteral(#field): { \
+    if(key == #field) { \
+      return ::Tinker::ReadJson(reader, object.field); \
+    } \
+    break; \
+  }
+
+/*
+ * Every key literal starts with a comma, which is skipped
+ * for the first field.
+ */
+#define TINKER_WRITE_FIELD(field) \
+  writer.Raw(",\"" #field "\":" + skip, \
+    sizeof(",\"" #field "\":") - 1 - skip); \
+  skip = 0; \
+  ::Tinker::WriteJson(writer, object.field);
+
+#define TINKER_JSON_FIELDS(Type, ...) \
+  inline ::Tinker::ReturnValue TinkerReadMember( \
+    ::Tinker::Reader &reader, \
+    Type &object, \
+    const std::string &key) { \
+    switch(::Tinker::HashKey(key)) { \
+      TINKER_FOR_EACH(TINKER_READ_FIELD, __VA_ARGS__) \
+      default: break; \
+    } \
+    return reader.SkipValue(); \
+  } \
+  inline void TinkerWriteMembers( \
+    ::Tinker::Writer &writer, \
+    const Type &object) { \
+    size_t skip = 1; \
+    TINKER_FOR_EACH(TINKER_WRITE_FIELD, __VA_ARGS__) \
+    (void)skip; \
+  }
+
+#endif //TINKER_JSON_PARSER_TINKER_MAPPER_H
@@ -0,0 +1,316 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerMemory.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerMemory.h"
+#include "source/TinkerValue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+std::atomic<Allocator *> gAllocator(nullptr);
+
+/*
+ * Short strings are stored inside the std::string object itself,
+ * only longer ones own a heap block of capacity() + 1 bytes.
+ */
+inline size_t StringHeapBytes(const std::string &str) {
+  const char *data = str.data();
+  const char *object = reinterpret_cast<const char *>(&str);
+  if(data >= object && data < object + sizeof(std::string)) {
+    return 0;
+  }
+  return str.capacity() + 1;
+}
+
+/*
+ * An unordered_map node holds the next pointer,
+ * the key/value pair and the cached hash code.
+ */
+inline size_t ObjectNodeBytes() {
+  return sizeof(void *) +
+    sizeof(std::pair<const std::string, Value *>) +
+    sizeof(size_t);
+}
+
+/**
+ * Memory statistics
+ */
+
+MemoryStats::MemoryStats() {
+  for(int i = kNull; i <= kObject; ++i) {
+    nodes[i] = 0;
+  }
+  node_bytes = 0;
+  string_bytes = 0;
+  container_bytes = 0;
+  key_bytes = 0;
+  allocations = 0;
+  total_bytes = 0;
+}
+
+MemoryStats Value::GetMemoryStats() const {
+  MemoryStats stats;
+  std::unordered_set<const Value *> shared;
+  CollectMemoryStats(stats, shared);
+  stats.total_bytes = stats.node_bytes + stats.string_bytes +
+    stats.container_bytes + stats.key_bytes;
+  return stats;
+}
+
+/*
+ * Every node counts its own bytes, but the heap block of a node
+ * is counted by its parent, since the root may live anywhere.
+ * A shared node is only counted the first time it is reached.
+ * The tree is walked with an explicit stack, as Free() does.
+ */
+void Value::CollectMemoryStats(
+  MemoryStats &stats,
+  std::unordered_set<const Value *> &shared) const {
+  std::vector<const Value *> pending(1, this);
+  while(!pending.empty()) {
+    const Value *value = pending.back();
+    pending.pop_back();
+    stats.nodes[value->_type]++;
+    stats.node_bytes += sizeof(Value);
+    if(value->_type == kNumber && (value->_flags & kFlagRawNumber)) {
+      size_t heap = StringHeapBytes((value->_value._raw)->text);
+      stats.string_bytes += sizeof(RawNumber) + heap;
+      stats.allocations += (heap > 0 ? 2 : 1);
+    } else if(value->_type == kString) {
+      size_t heap = StringHeapBytes(*(value->_value._string));
+      stats.string_bytes += sizeof(std::string) + heap;
+      stats.allocations += (heap > 0 ? 2 : 1);
+    } else if(value->_type == kArray) {
+      const std::vector<Value *> &array = *(value->_value._array);
+      stats.container_bytes += sizeof(array) +
+        array.capacity() * sizeof(Value *);
+      stats.allocations += (array.capacity() > 0 ? 2 : 1);
+      for(size_t i = 0; i < array.size(); ++i) {
+        const Value *child = array[i];
+        if((child->_flags & kFlagShared) && !shared.insert(child).second) {
+          continue;
+        }
+        stats.allocations++;
+        pending.push_back(child);
+      }
+    } else if(value->_type == kObject) {
+      const std::unordered_map<std::string, Value *> &object =
+        *(value->_value._object);
+      stats.container_bytes += sizeof(object) +
+        object.size() * ObjectNodeBytes();
+      stats.allocations += 1 + object.size();
+      if(object.bucket_count() > 1) {
+        stats.container_bytes += object.bucket_count() * sizeof(void *);
+        stats.allocations++;
+      }
+      for(auto it = object.begin(); it != object.end(); ++it) {
+        size_t heap = StringHeapBytes(it->first);
+        stats.key_bytes += heap;
+        stats.allocations += (heap > 0 ? 2 : 1);
+        const Value *child = it->second;
+        if((child->_flags & kFlagShared) && !shared.insert(child).second) {
+          continue;
+        }
+        stats.allocations++;
+        pending.push_back(child);
+      }
+    }
+  }
+}
+
+/**
+ * Allocator hook
+ */
+
+Allocator::~Allocator() {
+}
+
+void SetAllocator(Allocator *allocator) {
+  gAllocator.store(allocator, std::memory_order_release);
+}
+
+Allocator* GetAllocator() {
+  return gAllocator.load(std::memory_order_acquire);
+}
+
+void* Value::operator new(size_t size) {
+  Allocator *allocator = gAllocator.load(std::memory_order_relaxed);
+  if(allocator == nullptr) {
+    return ::operator new(size);
+  }
+  return allocator->Allocate(size);
+}
+
+void Value::operator delete(void *pointer, size_t size) {
+  Allocator *allocator = gAllocator.load(std::memory_order_relaxed);
+  if(allocator == nullptr) {
+    ::operator delete(pointer);
+  } else {
+    allocator->Deallocate(pointer, size);
+  }
+}
+
+/**
+ * Background free
+ */
+
+/*
+ * The queue of the background thread. It lives until the end of
+ * the program, and its destructor frees what is left in the queue
+ * before joining the thread.
+ */
+class BackgroundFreer {
+ public:
+  BackgroundFreer() : _stopping(false), _pending(0) {
+  }
+
+  ~BackgroundFreer() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _stopping = true;
+    lock.unlock();
+    _ready.notify_all();
+    if(_thread.joinable()) {
+      _thread.join();
+    }
+  }
+
+  void Push(Value *value) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!_thread.joinable()) {
+      _thread = std::thread(&BackgroundFreer::Run, this);
+    }
+    _queue.push_back(value);
+    _pending++;
+    _ready.notify_one();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return _pending == 0; });
+  }
+
+  size_t GetPending() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending;
+  }
+
+ private:
+  void Run() {
+    std::vector<Value *> batch;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true) {
+      _ready.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+      if(_queue.empty()) {
+        return;
+      }
+      batch.swap(_queue);
+      lock.unlock();
+      for(size_t i = 0; i < batch.size(); ++i) {
+        delete batch[i];
+      }
+      lock.lock();
+      _pending -= batch.size();
+      batch.clear();
+      _done.notify_all();
+    }
+  }
+
+  std::mutex _mutex;
+  std::condition_variable _ready;
+  std::condition_variable _done;
+  std::vector<Value *> _queue;
+  std::thread _thread;
+  bool _stopping;
+  size_t _pending;
+};
+
+static BackgroundFreer& GetBackgroundFreer() {
+  static BackgroundFreer freer;
+  return freer;
+}
+
+/*
+ * Leaves and borrowed trees are cheap to free, so they are freed
+ * at once. Other trees move into a new root node which is queued,
+ * the caller only pays for that node and the hand-over.
+ */
+void Value::FreeInBackground() {
+  if((_flags & kFlagBorrowed) || (_type != kArray && _type != kObject)) {
+    Free();
+    return;
+  }
+  Value *detached = new Value();
+  detached->Swap(*this);
+  GetBackgroundFreer().Push(detached);
+}
+
+void WaitForBackgroundFree() {
+  GetBackgroundFreer().Wait();
+}
+
+size_t GetBackgroundFreePending() {
+  return GetBackgroundFreer().GetPending();
+}
+
+/**
+ * Counting allocator
+ */
+
+CountingAllocator::CountingAllocator()
+  : _allocations(0), _deallocations(0), _allocated_bytes(0), _live_bytes(0) {
+}
+
+void* CountingAllocator::Allocate(size_t size) {
+  _allocations.fetch_add(1, std::memory_order_relaxed);
+  _allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  _live_bytes.fetch_add(size, std::memory_order_relaxed);
+  return ::operator new(size);
+}
+
+void CountingAllocator::Deallocate(void *pointer, size_t size) {
+  _deallocations.fetch_add(1, std::memory_order_relaxed);
+  _live_bytes.fetch_sub(size, std::memory_order_relaxed);
+  ::operator delete(pointer);
+}
+
+size_t CountingAllocator::GetAllocations() const {
+  return _allocations.load(std::memory_order_relaxed);
+}
+
+size_t CountingAllocator::GetDeallocations() const {
+  return _deallocations.load(std::memory_order_relaxed);
+}
+
+size_t CountingAllocator::GetAllocatedBytes() const {
+  return _allocated_bytes.load(std::memory_order_relaxed);
+}
+
+size_t CountingAllocator::GetLiveBytes() const {
+  return _live_bytes.load(std::memory_order_relaxed);
+}
+
+void CountingAllocator::Reset() {
+  _allocations.store(0, std::memory_order_relaxed);
+  _deallocations.store(0, std::memory_order_relaxed);
+  _allocated_bytes.store(0, std::memory_order_relaxed);
+}
+}
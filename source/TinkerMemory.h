@@ -0,0 +1,91 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerMemory.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_MEMORY_H
+#define TINKER_JSON_PARSER_TINKER_MEMORY_H
+
+#include "TinkerConstant.h"
+
+#include <atomic>
+#include <cstddef>
+
+namespace Tinker {
+/*
+ * Memory usage of a Value tree, filled by Value::GetMemoryStats().
+ * The nodes are counted exactly, the bytes and the allocations
+ * of strings and containers are derived from their capacities,
+ * so they are close estimates of what the standard library allocated.
+ */
+struct MemoryStats {
+  MemoryStats();
+
+  size_t nodes[kObject + 1];  // Number of nodes of each Type
+  size_t node_bytes;          // Value nodes
+  size_t string_bytes;        // String values
+  size_t container_bytes;     // Array and object storage
+  size_t key_bytes;           // Object member keys
+  size_t allocations;         // Heap blocks held by the tree
+  size_t total_bytes;         // Sum of the byte counters above
+};
+
+/*
+ * The allocator used for the Value nodes created by the library.
+ * Only the nodes go through it: strings, raw numbers, and the storage
+ * of arrays and objects are standard containers, which always use the
+ * global operator new. GetMemoryStats() estimates those instead.
+ * No allocator is installed by default, in which case the nodes use
+ * the global operator new and the hook costs one predictable branch.
+ * An allocator must be installed before any node is created
+ * and stay alive while any node allocated by it exists.
+ */
+class Allocator {
+ public:
+  virtual ~Allocator();
+  virtual void* Allocate(size_t size) = 0;
+  virtual void Deallocate(void *pointer, size_t size) = 0;
+};
+
+void SetAllocator(Allocator *allocator);
+Allocator* GetAllocator();
+
+/*
+ * Value::FreeInBackground() hands trees over to a single thread,
+ * started on first use, which frees them in the order they came.
+ * The nodes go back to the installed Allocator from that thread.
+ * WaitForBackgroundFree() returns once every tree handed over
+ * before the call has been freed.
+ */
+void WaitForBackgroundFree();
+size_t GetBackgroundFreePending();
+
+/*
+ * Forwards to the global operator new and counts the calls, e.g. to
+ * measure the number of nodes each Parse() allocates. The payloads of
+ * the nodes are not counted, see Allocator.
+ */
+class CountingAllocator : public Allocator {
+ public:
+  CountingAllocator();
+
+  void* Allocate(size_t size) override;
+  void Deallocate(void *pointer, size_t size) override;
+
+  size_t GetAllocations() const;
+  size_t GetDeallocations() const;
+  size_t GetAllocatedBytes() const;
+  size_t GetLiveBytes() const;
+  void Reset();
+
+ private:
+  std::atomic<size_t> _allocations;
+  std::atomic<size_t> _deallocations;
+  std::atomic<size_t> _allocated_bytes;
+  std::atomic<size_t> _live_bytes;
+};
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_MEMORY_H
@@ -0,0 +1,438 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerParallel.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerSimd.h"
+#include "source/TinkerStream.h"
+#include "source/TinkerValue.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+/*
+ * Inputs smaller than this are always parsed sequentially
+ * when the number of threads is chosen automatically,
+ * since starting the threads costs more than it saves.
+ */
+static const size_t kParallelMinBytes = 1 << 20;
+
+inline const char* SkipWhitespace(const char *pointer) {
+  while(*pointer == ' ' || *pointer == '\t' ||
+    *pointer == '\n' || *pointer == '\r') {
+    ++pointer;
+  }
+  return pointer;
+}
+
+inline size_t ResolveThreadCount(size_t threads) {
+  if(threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  return (threads == 0 ? 1 : threads);
+}
+
+/*
+ * Runs task(0) ... task(count - 1) concurrently.
+ * The first task runs on the calling thread.
+ */
+static void RunParallelTasks(
+  size_t count,
+  const std::function<void(size_t)> &task) {
+  std::vector<std::thread> workers;
+  for(size_t i = 1; i < count; ++i) {
+    workers.emplace_back(task, i);
+  }
+  if(count > 0) {
+    task(0);
+  }
+  for(size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+}
+
+/*
+ * Splits the body of a top-level array into at most "chunks" ranges.
+ * Every range starts at the first character of an element,
+ * the last range ends at the closing bracket of the array.
+ * The scanner only tracks quotes, escapes and bracket depth,
+ * the elements are validated later by the real parser.
+ * Returns false if the text is not a well-formed top-level array,
+ * in which case the caller falls back to the sequential parser.
+ */
+static bool SplitTopLevelArray(
+  const char *json,
+  size_t chunks,
+  std::vector<const char *> &bounds) {
+  const char *pointer = SkipWhitespace(json);
+  if(*pointer != '[') {
+    return false;
+  }
+  const char *begin = SkipWhitespace(pointer + 1);
+  bounds.push_back(begin);
+  if(*begin == ']') {
+    bounds.push_back(begin);
+    return true;
+  }
+
+  size_t length = 0;
+  while(begin[length] != '\0') {
+    ++length;
+  }
+  size_t step = length / chunks + 1;
+  const char *next_split = begin + step;
+  size_t depth = 0;
+  pointer = begin;
+  while(true) {
+    switch(*pointer) {
+      case '\0': {
+        return false;
+      }
+      case '"': {
+        ++pointer;
+        while(*pointer != '"') {
+          if(*pointer == '\0') return false;
+          if(*pointer == '\\') {
+            if(*(++pointer) == '\0') return false;
+          }
+          ++pointer;
+        }
+        ++pointer;
+        break;
+      }
+      case '[':
+      case '{': {
+        ++depth;
+        ++pointer;
+        break;
+      }
+      case ']':
+      case '}': {
+        if(depth == 0) {
+          if(*pointer != ']') return false;
+          bounds.push_back(pointer);
+          return true;
+        }
+        --depth;
+        ++pointer;
+        break;
+      }
+      case ',': {
+        ++pointer;
+        if(depth == 0 && pointer >= next_split) {
+          pointer = SkipWhitespace(pointer);
+          // A trailing comma, which Parse() reports
+          if(*pointer == ']') return false;
+          bounds.push_back(pointer);
+          next_split = pointer + step;
+        }
+        break;
+      }
+      default: {
+        ++pointer;
+      }
+    }
+  }
+}
+
+/**
+ * Parallel parser
+ */
+
+/*
+ * Parses a document whose root is a very large array on several threads.
+ * The element boundaries are located first, then every thread parses
+ * a contiguous range of elements into its own vector,
+ * and the vectors are stitched into the root array in order.
+ * Any other document, or any error, is handed to the sequential Parse(),
+ * so the result and the error codes are always the same as Parse().
+ * Passing 0 as threads uses all the hardware threads
+ * and keeps small inputs on the sequential path.
+ */
+ReturnValue Value::ParseParallel(
+  const char *json,
+  size_t threads,
+  unsigned flags) {
+  bool automatic = (threads == 0);
+  threads = ResolveThreadCount(threads);
+  std::vector<const char *> bounds;
+  // The elements are parsed without ParseRoot(), which checks the encoding
+  bool invalid_utf8 = false;
+  if(threads != 1 && (flags & kParseValidateUtf8)) {
+    const char *end = json + strlen(json);
+    invalid_utf8 = (ScanInvalidUtf8(json, end) != end);
+  }
+  if(threads == 1 || invalid_utf8 ||
+    !SplitTopLevelArray(json, threads, bounds) ||
+    (automatic && (size_t)(bounds.back() - json) < kParallelMinBytes)) {
+    return Parse(json, flags);
+  }
+
+  size_t tasks = bounds.size() - 1;
+  const char *closing = bounds.back();
+  std::vector<std::vector<Value *> > parts(tasks);
+  std::vector<char> failed(tasks, 0);
+  RunParallelTasks(tasks, [&](size_t task) {
+    const char *pointer = bounds[task];
+    const char *end = bounds[task + 1];
+    std::vector<Value *> &part = parts[task];
+    std::vector<ParseFrame> stack;
+    while(pointer != end) {
+      Value *element = new Value();
+      if(element->ParseValue(
+        pointer, nullptr, flags, stack, kDefaultMaxDepth - 1) != kOk) {
+        delete element;
+        failed[task] = 1;
+        return;
+      }
+      part.push_back(element);
+      pointer = SkipWhitespace(pointer);
+      if(pointer == closing) {
+        break;
+      } else if(*pointer != ',') {
+        failed[task] = 1;
+        return;
+      }
+      pointer = SkipWhitespace(pointer + 1);
+      if(pointer == closing) {
+        failed[task] = 1;
+        return;
+      }
+    }
+    if(pointer != end) {
+      failed[task] = 1;
+    }
+  });
+
+  bool success = (*SkipWhitespace(closing + 1) == '\0');
+  size_t total = 0;
+  for(size_t i = 0; i < tasks; ++i) {
+    success = success && !failed[i];
+    total += parts[i].size();
+  }
+  if(!success) {
+    for(size_t i = 0; i < tasks; ++i) {
+      for(size_t j = 0; j < parts[i].size(); ++j) {
+        delete parts[i][j];
+      }
+    }
+    return Parse(json, flags);
+  }
+
+  Free();
+  _value._array = new std::vector<Value *>();
+  (_value._array)->reserve(total);
+  for(size_t i = 0; i < tasks; ++i) {
+    (_value._array)->insert(
+      (_value._array)->end(), parts[i].begin(), parts[i].end());
+  }
+  _type = kArray;
+  return kOk;
+}
+
+/**
+ * Parallel stringifier
+ */
+
+/*
+ * Serializes the document on several threads.
+ * The largest containers near the root are split into a sequence of
+ * pieces, each piece being either a literal (the brackets, comma and
+ * key around a container which was split further) or a range of the
+ * children of a container, written with their brackets, commas and
+ * keys. Only a few pieces per thread are made, whatever the size of
+ * the containers. Contiguous runs of pieces are stringified into
+ * separate buffers, so the output is byte-identical to Stringify().
+ * The buffers are handed out as they are, which saves the final copy
+ * when they are written out with writev() or similar functions.
+ * kStringifyCached is ignored, the cache is not shared by threads.
+ */
+ReturnValue Value::StringifyParallel(
+  std::vector<std::string> &parts,
+  size_t threads,
+  unsigned flags) const {
+  flags &= ~kStringifyCached;
+  threads = ResolveThreadCount(threads);
+  parts.clear();
+  if(threads == 1 || (_type != kArray && _type != kObject)) {
+    parts.resize(1);
+    return Stringify(parts[0], flags);
+  }
+
+  typedef std::unordered_map<std::string, Value *>::const_iterator Member;
+  struct Piece {
+    const Value *value;  // Container of the range, nullptr for a literal
+    size_t begin;
+    size_t end;
+    Member member;       // Member at begin, for an object
+    std::string literal;
+  };
+  auto size_of = [](const Value *value) -> size_t {
+    if(value->_type == kArray) {
+      return (value->_value._array)->size();
+    } else if(value->_type == kObject) {
+      return (value->_value._object)->size();
+    }
+    return 0;
+  };
+  auto make_range = [&](const Value *value, size_t begin, size_t end,
+    Member member) -> Piece {
+    Piece piece;
+    piece.value = value;
+    piece.begin = begin;
+    piece.end = end;
+    piece.member = member;
+    return piece;
+  };
+  auto make_literal = [](const std::string &literal) -> Piece {
+    Piece piece;
+    piece.value = nullptr;
+    piece.begin = 0;
+    piece.end = 0;
+    piece.literal = literal;
+    return piece;
+  };
+  auto first_member = [](const Value *value) -> Member {
+    return (value->_type == kObject ? (value->_value._object)->begin() :
+      Member());
+  };
+  auto child_of = [](const Piece &piece) -> const Value* {
+    return (piece.value->_type == kArray ?
+      (piece.value->_value._array)->at(piece.begin) : piece.member->second);
+  };
+  // Children of a range, or those of its only child
+  auto weight = [&](const Piece &piece) -> size_t {
+    if(piece.value == nullptr) {
+      return 0;
+    }
+    size_t count = piece.end - piece.begin;
+    return (count == 1 ? size_of(child_of(piece)) : count);
+  };
+
+  std::vector<Piece> pieces;
+  pieces.push_back(make_range(this, 0, size_of(this), first_member(this)));
+  size_t wanted = threads * 8;
+  while(pieces.size() < wanted) {
+    size_t target = 0;
+    size_t largest = 0;
+    for(size_t i = 0; i < pieces.size(); ++i) {
+      size_t size = weight(pieces[i]);
+      if(size > largest) {
+        largest = size;
+        target = i;
+      }
+    }
+    if(largest < 2) {
+      break;
+    }
+
+    Piece piece = pieces[target];
+    bool array = (piece.value->_type == kArray);
+    std::vector<Piece> expanded;
+    size_t count = piece.end - piece.begin;
+    if(count > 1) {
+      size_t ranges = (count < wanted ? count : wanted);
+      Member member = piece.member;
+      size_t begin = piece.begin;
+      for(size_t i = 1; i <= ranges; ++i) {
+        size_t end = piece.begin + count * i / ranges;
+        expanded.push_back(make_range(piece.value, begin, end, member));
+        if(!array) {
+          std::advance(member, end - begin);
+        }
+        begin = end;
+      }
+    } else {
+      // The only child is split in turn, between its comma and key
+      // and the closing bracket of the range
+      std::string prefix(piece.begin == 0 ? (array ? "[" : "{") : ",");
+      if(!array) {
+        Writer(prefix, flags).String(piece.member->first);
+        prefix += ":";
+      }
+      const Value *child = child_of(piece);
+      expanded.push_back(make_literal(prefix));
+      expanded.push_back(make_range(child, 0, size_of(child),
+        first_member(child)));
+      if(piece.end == size_of(piece.value)) {
+        expanded.push_back(make_literal(array ? "]" : "}"));
+      }
+    }
+    pieces.erase(pieces.begin() + target);
+    pieces.insert(pieces.begin() + target, expanded.begin(), expanded.end());
+  }
+
+  size_t tasks = (pieces.size() < threads ? pieces.size() : threads);
+  size_t step = (pieces.size() + tasks - 1) / tasks;
+  parts.resize(tasks);
+  RunParallelTasks(tasks, [&](size_t task) {
+    size_t end = (task + 1) * step;
+    if(end > pieces.size()) {
+      end = pieces.size();
+    }
+    std::string &text = parts[task];
+    for(size_t i = task * step; i < end; ++i) {
+      const Piece &piece = pieces[i];
+      if(piece.value == nullptr) {
+        text += piece.literal;
+        continue;
+      }
+      bool array = (piece.value->_type == kArray);
+      if(piece.begin == 0) {
+        text.push_back(array ? '[' : '{');
+      }
+      Member member = piece.member;
+      for(size_t j = piece.begin; j < piece.end; ++j) {
+        if(j > 0) {
+          text.push_back(',');
+        }
+        if(array) {
+          (piece.value->_value._array)->at(j)->Stringify(text, flags);
+        } else {
+          Writer(text, flags).String(member->first);
+          text.push_back(':');
+          member->second->Stringify(text, flags);
+          ++member;
+        }
+      }
+      if(piece.end == size_of(piece.value)) {
+        text.push_back(array ? ']' : '}');
+      }
+    }
+  });
+  return kOk;
+}
+
+ReturnValue Value::StringifyParallel(
+  std::string &text,
+  size_t threads,
+  unsigned flags) const {
+  std::vector<std::string> parts;
+  ReturnValue result = StringifyParallel(parts, threads, flags);
+  size_t length = text.length();
+  for(size_t i = 0; i < parts.size(); ++i) {
+    length += parts[i].length();
+  }
+  text.reserve(length);
+  for(size_t i = 0; i < parts.size(); ++i) {
+    text += parts[i];
+  }
+  return result;
+}
+}
@@ -6,22 +6,162 @@
  */
 
 #include "source/TinkerConstant.h"
+#include "source/TinkerContext.h"
+#include "source/TinkerProfiler.h"
+#include "source/TinkerSimd.h"
 #include "source/TinkerValue.h"
 
 #include <cerrno>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#ifdef TINKER_PARSER_PROFILING
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
 
 namespace Tinker {
+/**
+ * Profiling counters
+ */
+
+const char *PhaseString[kPhaseCount] = {
+  "Parse",
+  "Whitespace",
+  "Number",
+  "String",
+  "Allocation"
+};
+
+ParserStats::ParserStats() {
+  for(int i = 0; i < kPhaseCount; ++i) {
+    cycles[i] = 0;
+    bytes[i] = 0;
+    calls[i] = 0;
+  }
+  for(int i = kNull; i <= kObject; ++i) {
+    tokens[i] = 0;
+  }
+  keys = 0;
+}
+
+thread_local ParserStats gParserStats;
+
+bool IsParserProfilingEnabled() {
+#ifdef TINKER_PARSER_PROFILING
+  return true;
+#else
+  return false;
+#endif
+}
+
+ParserStats GetParserStats() {
+  return gParserStats;
+}
+
+void ResetParserStats() {
+  gParserStats = ParserStats();
+}
+
+#ifdef TINKER_PARSER_PROFILING
+inline uint64_t ReadCycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/*
+ * Records the time spent in a scope, and the input consumed
+ * if the scope is given the parser cursor.
+ */
+class PhaseScope {
+ public:
+  PhaseScope(ParserPhase phase, const char *const *cursor)
+    : _phase(phase),
+      _cursor(cursor),
+      _start(cursor == nullptr ? nullptr : *cursor),
+      _cycles(ReadCycleCounter()) {
+  }
+
+  ~PhaseScope() {
+    gParserStats.cycles[_phase] += ReadCycleCounter() - _cycles;
+    gParserStats.calls[_phase]++;
+    if(_cursor != nullptr) {
+      gParserStats.bytes[_phase] += *_cursor - _start;
+    }
+  }
+
+ private:
+  ParserPhase _phase;
+  const char *const *_cursor;
+  const char *_start;
+  uint64_t _cycles;
+};
+
+#define TINKER_PROFILE_PHASE(phase, cursor) PhaseScope phase_scope(phase, cursor)
+#define TINKER_PROFILE_TOKEN(type) gParserStats.tokens[type]++
+#define TINKER_PROFILE_KEY() gParserStats.keys++
+#else
+#define TINKER_PROFILE_PHASE(phase, cursor)
+#define TINKER_PROFILE_TOKEN(type)
+#define TINKER_PROFILE_KEY()
+#endif
+
 /**
  * Tool functions
  */
 
+/*
+ * Without a context the parser allocates from the heap,
+ * with a context it reuses the objects kept by the context.
+ */
+inline Value* Value::NewValue(ParserContext *context) {
+  TINKER_PROFILE_PHASE(kPhaseAllocation, nullptr);
+  return (context == nullptr ? new Value() : context->AcquireValue());
+}
+
+inline std::string* Value::NewString(ParserContext *context) {
+  TINKER_PROFILE_PHASE(kPhaseAllocation, nullptr);
+  return (context == nullptr ? new std::string() : context->AcquireString());
+}
+
+inline RawNumber* Value::NewRawNumber(ParserContext *context) {
+  TINKER_PROFILE_PHASE(kPhaseAllocation, nullptr);
+  return (context == nullptr ? new RawNumber() : context->AcquireRawNumber());
+}
+
+inline std::vector<Value *>* Value::NewArray(ParserContext *context) {
+  TINKER_PROFILE_PHASE(kPhaseAllocation, nullptr);
+  return (context == nullptr ?
+    new std::vector<Value *>() : context->AcquireArray());
+}
+
+inline std::unordered_map<std::string, Value *>* Value::NewObject(
+  ParserContext *context) {
+  TINKER_PROFILE_PHASE(kPhaseAllocation, nullptr);
+  return (context == nullptr ?
+    new std::unordered_map<std::string, Value *>() : context->AcquireObject());
+}
+
+inline void DeleteValue(Value *value, ParserContext *context) {
+  if(context == nullptr) {
+    delete value;
+  }
+}
+
 inline bool IsDigit(char ch) {
   return (ch >= '0' && ch <= '9');
 }
@@ -30,13 +170,6 @@ inline bool IsDigit1To9(char ch) {
   return (ch >= '1' && ch <= '9');
 }
 
-ReturnValue DeleteString(
-  std::string *str,
-  ReturnValue result) {
-  delete str;
-  return result;
-}
-
 inline const char* ParseHex4(const char *pointer, unsigned *u) {
   *u = 0;
   for (int i = 0; i < 4; ++i) {
@@ -73,108 +206,340 @@ inline void EncodeUtf8(std::string *str, unsigned u) {
  */
 
 /*
- * Note that this is the only API exposed to the users.
+ * Note that these are the only APIs exposed to the users.
  * Any other parser functions are private and invisible to the outside.
  */
-ReturnValue Value::Parse(const char *json) {
+ReturnValue Value::Parse(const char *json, unsigned flags) {
   Free();
-  _json = json;
+  return ParseRoot(json, nullptr, flags);
+}
+
+/*
+ * Parses with the objects kept by the context,
+ * the previous tree parsed with the context becomes invalid.
+ */
+ReturnValue Value::Parse(
+  const char *json,
+  ParserContext &context,
+  unsigned flags) {
+  Free();
+  context.Reset();
+  return ParseRoot(json, &context, flags);
+}
+
+/**
+ * The functions below are private.
+ */
+
+ReturnValue Value::ParseRoot(
+  const char *json,
+  ParserContext *context,
+  unsigned flags) {
+  TINKER_PROFILE_PHASE(kPhaseParse, &json);
   _type = kNull;
+  if(flags & kParseValidateUtf8) {
+    // Structural characters are ASCII, so only strings can break this
+    const char *end = json + strlen(json);
+    if(ScanInvalidUtf8(json, end) != end) {
+      return kInvalidUtf8;
+    }
+  }
+  std::vector<ParseFrame> local_stack;
   ReturnValue result;
-  ParseWhitespace();
-  result = ParseValue();
+  ParseWhitespace(json);
+  if(context == nullptr) {
+    result = ParseValue(json, nullptr, flags, local_stack, kDefaultMaxDepth);
+  } else {
+    result = ParseValue(
+      json, context, flags, context->_stack, context->_max_depth);
+  }
   if(result == kOk) {
-    ParseWhitespace();
-    if(*_json != '\0') {
-      _type = kNull;
+    ParseWhitespace(json);
+    if(*json != '\0') {
+      Free();
       return kNotSingular;
     }
   }
   return result;
 }
 
-/**
- * The functions below are private.
- */
-
-void Value::ParseWhitespace() {
-  const char *pointer = _json;
+void Value::ParseWhitespace(const char *&json) {
+  TINKER_PROFILE_PHASE(kPhaseWhitespace, &json);
+  const char *pointer = json;
   while(*pointer == ' ' || *pointer == '\t' ||
     *pointer == '\n' || *pointer == '\r') {
     ++pointer;
   }
-  _json = pointer;
+  json = pointer;
 }
 
-ReturnValue Value::ParseValue() {
-  switch(*_json) {
-    case 'n': return ParseLiteral("null", kNull);
-    case 't': return ParseLiteral("true", kTrue);
-    case 'f': return ParseLiteral("false", kFalse);
-    case '"': return ParseString();
-    case '[': return ParseArray();
-    case '{': return ParseObject();
-    case '\0': return kExpectValue;
-    default: return ParseNumber();
+/*
+ * Parses a value without recursion.
+ * Every open array or object is a frame of the stack, the frames
+ * are reused from one parse to the next and keep their key buffers.
+ * A value is attached to its container once it is complete,
+ * so on an error the detached values are deleted from the top
+ * of the stack down, and the root is left as null.
+ * Containers nested deeper than max_depth are rejected.
+ */
+ReturnValue Value::ParseValue(
+  const char *&json,
+  ParserContext *context,
+  unsigned flags,
+  std::vector<ParseFrame> &stack,
+  size_t max_depth) {
+  unsigned borrowed = (context == nullptr ? 0 : kFlagBorrowed);
+  size_t depth = 0;
+  Value *value = this;
+  ReturnValue result = kOk;
+  while(result == kOk) {
+    bool complete = true;
+    switch(*json) {
+      case 'n': result = value->ParseLiteral(json, "null", kNull); break;
+      case 't': result = value->ParseLiteral(json, "true", kTrue); break;
+      case 'f': result = value->ParseLiteral(json, "false", kFalse); break;
+      case '"': result = value->ParseString(json, context, flags); break;
+      case '[':
+      case '{': {
+        if(depth == max_depth) {
+          result = kDepthLimitExceeded;
+          break;
+        }
+        char closing = (*json == '[' ? ']' : '}');
+        if(closing == ']') {
+          value->_value._array = NewArray(context);
+          value->_type = kArray;
+        } else {
+          value->_value._object = NewObject(context);
+          value->_type = kObject;
+        }
+        value->_flags |= borrowed;
+        json++;
+        ParseWhitespace(json);
+        if(*json == closing) {
+          json++;
+          TINKER_PROFILE_TOKEN(value->_type);
+          break;
+        }
+        if(depth == stack.size()) {
+          stack.resize(depth + 1);
+        }
+        ParseFrame &frame = stack[depth++];
+        frame.value = value;
+        value = nullptr;
+        if(closing == '}') {
+          result = ParseKey(json, &frame.key, flags);
+          if(result != kOk) {
+            break;
+          }
+        }
+        value = NewValue(context);
+        complete = false;
+        break;
+      }
+      case '\0': result = kExpectValue; break;
+      default: result = value->ParseNumber(json, context, flags);
+    }
+    if(result != kOk || !complete) {
+      continue;
+    }
+
+    // Attach the complete value, and close the containers it completes
+    while(depth > 0) {
+      ParseFrame &frame = stack[depth - 1];
+      Value *container = frame.value;
+      bool array = (container->_type == kArray);
+      if(array) {
+        (container->_value._array)->push_back(value);
+      } else if(!(container->_value._object)->insert(
+        {frame.key, value}).second) {
+        DeleteValue(value, context);
+      }
+      value = nullptr;
+      ParseWhitespace(json);
+      if(*json == ',') {
+        json++;
+        ParseWhitespace(json);
+        if(!array) {
+          result = ParseKey(json, &frame.key, flags);
+          if(result != kOk) {
+            break;
+          }
+        }
+        value = NewValue(context);
+        break;
+      } else if(*json == (array ? ']' : '}')) {
+        json++;
+        TINKER_PROFILE_TOKEN(container->_type);
+        value = container;
+        --depth;
+      } else {
+        result = (array ? kMissCommaOrSquareBracket : kMissCommaOrCurlyBracket);
+        break;
+      }
+    }
+    if(depth == 0 && result == kOk) {
+      return kOk;
+    }
+  }
+
+  if(value != this) {
+    DeleteValue(value, context);
+  }
+  while(depth > 0) {
+    Value *container = stack[--depth].value;
+    if(container != this) {
+      DeleteValue(container, context);
+    }
   }
+  Free();
+  return result;
 }
 
-ReturnValue Value::ParseLiteral(const char *literal, Type type) {
-  _json++;
-  const char *pointer = _json;
+ReturnValue Value::ParseLiteral(
+  const char *&json,
+  const char *literal,
+  Type type) {
+  const char *pointer = json + 1;
   for (size_t i = 0; literal[i + 1]; ++i)
     if (*(pointer++) != literal[i + 1])
       return kInvalidValue;
-  _json = pointer;
+  json = pointer;
   _type = type;
+  TINKER_PROFILE_TOKEN(type);
   return kOk;
 }
 
-ReturnValue Value::ParseNumber() {
-  const char *pointer = _json;
-  if(*pointer == '-') pointer++;
+/*
+ * Integers without fraction and exponent are stored exactly
+ * as int64_t, or as uint64_t when they only fit in it.
+ * Other numbers, integers out of these ranges and "-0" are doubles.
+ * The digits of the integer part are accumulated while validating,
+ * an integer of 20 digits is the only one which may overflow.
+ *
+ * With kParseRawNumbers the validated text is kept instead,
+ * strtod() only runs for the rare numbers which may be too big.
+ */
+ReturnValue Value::ParseNumber(
+  const char *&json,
+  ParserContext *context,
+  unsigned flags) {
+  TINKER_PROFILE_PHASE(kPhaseNumber, &json);
+  const char *pointer = json;
+  bool negative = false;
+  bool integer = true;
+  bool overflow = false;
+  bool exact = false;
+  uint64_t magnitude = 0;
+  size_t integer_digits = 0;
+  size_t exponent = 0;
+  bool negative_exponent = false;
+  if(*pointer == '-') {
+    negative = true;
+    pointer++;
+  }
   if(*pointer == '0') {
     pointer++;
   } else {
     if(!IsDigit1To9(*pointer)) return kInvalidValue;
-    do pointer++; while(IsDigit(*pointer));
+    const char *digits = pointer;
+    do {
+      unsigned digit = *pointer - '0';
+      if(pointer - digits >= 19 &&
+        (pointer - digits > 19 ||
+          magnitude > (UINT64_MAX - digit) / 10)) {
+        overflow = true;
+      }
+      magnitude = magnitude * 10 + digit;
+      pointer++;
+    } while(IsDigit(*pointer));
+    integer_digits = pointer - digits;
   }
   if(*pointer == '.') {
+    integer = false;
     pointer++;
     if(!IsDigit(*pointer)) return kInvalidValue;
     do pointer++; while(IsDigit(*pointer));
   }
   if(*pointer == 'e' || *pointer == 'E') {
+    integer = false;
     pointer++;
-    if(*pointer == '+' || *pointer == '-') pointer++;
+    if(*pointer == '+' || *pointer == '-') {
+      negative_exponent = (*pointer == '-');
+      pointer++;
+    }
     if(!IsDigit(*pointer)) return kInvalidValue;
-    do pointer++; while(IsDigit(*pointer));
+    do {
+      if(exponent < 100000) exponent = exponent * 10 + (*pointer - '0');
+      pointer++;
+    } while(IsDigit(*pointer));
   }
 
-  errno = 0;
-  _value._number = strtod(_json, nullptr);
-  if(errno == ERANGE &&
-    (_value._number == HUGE_VAL ||
-      _value._number == -HUGE_VAL)) {
-    return kNumberTooBig;
+  if(flags & kParseRawNumbers) {
+    if(integer_digits + (negative_exponent ? 0 : exponent) > 308) {
+      errno = 0;
+      double number = strtod(json, nullptr);
+      if(errno == ERANGE && (number == HUGE_VAL || number == -HUGE_VAL)) {
+        return kNumberTooBig;
+      }
+    }
+    _value._raw = NewRawNumber(context);
+    (_value._raw)->text.assign(json, pointer - json);
+    _flags |= kFlagRawNumber | (context == nullptr ? 0 : kFlagBorrowed);
+    _type = kNumber;
+    json = pointer;
+    TINKER_PROFILE_TOKEN(kNumber);
+    return kOk;
+  }
+
+  if(integer && negative && magnitude == 0) {
+    // strtod() would read on into "-01" or "-0x1"
+    _value._number = -0.0;
+    exact = true;
+  } else if(integer && !overflow) {
+    if(!negative && magnitude > (uint64_t)INT64_MAX) {
+      _value._uint64 = magnitude;
+      _flags |= kFlagUint64;
+      exact = true;
+    } else if(!negative || magnitude <= (uint64_t)INT64_MAX + 1) {
+      _value._int64 = (negative ?
+        (magnitude == (uint64_t)INT64_MAX + 1 ?
+          INT64_MIN : -(int64_t)magnitude) :
+        (int64_t)magnitude);
+      _flags |= kFlagInt64;
+      exact = true;
+    }
+  }
+  if(!exact) {
+    errno = 0;
+    _value._number = strtod(json, nullptr);
+    if(errno == ERANGE &&
+      (_value._number == HUGE_VAL ||
+        _value._number == -HUGE_VAL)) {
+      return kNumberTooBig;
+    }
   }
   _type = kNumber;
-  _json = pointer;
+  json = pointer;
+  TINKER_PROFILE_TOKEN(kNumber);
   return kOk;
 }
 
-ReturnValue Value::ParseRawString(std::string *str) {
-  _json++;
-  const char *pointer = _json;
+ReturnValue Value::ParseRawString(
+  const char *&json,
+  std::string *str,
+  unsigned flags) {
+  TINKER_PROFILE_PHASE(kPhaseString, &json);
+  const char *pointer = json + 1;
   while(true) {
     char ch = *pointer++;
     switch(ch) {
       case '\"': {
-        _json = pointer;
+        json = pointer;
         return kOk;
       }
       case '\0': {
-        return DeleteString(str, kMissQuotationMark);
+        return kMissQuotationMark;
       }
       case '\\': {
         switch(*pointer++) {
@@ -190,153 +555,82 @@ ReturnValue Value::ParseRawString(std::string *str) {
             unsigned u1, u2;
             pointer = ParseHex4(pointer, &u1);
             if(pointer == nullptr)
-              return DeleteString(str, kInvalidUnicodeHex);
+              return kInvalidUnicodeHex;
             if(u1 >= 0xD800 && u1 <= 0xDBFF) {
               if(*pointer++ != '\\')
-                return DeleteString(str, kInvalidUnicodeSurrogate);
+                return kInvalidUnicodeSurrogate;
               if(*pointer++ != 'u')
-                return DeleteString(str, kInvalidUnicodeSurrogate);
+                return kInvalidUnicodeSurrogate;
               pointer = ParseHex4(pointer, &u2);
               if(pointer == nullptr)
-                return DeleteString(str, kInvalidUnicodeHex);
+                return kInvalidUnicodeHex;
               if(u2 < 0xDC00 || u2 > 0xDFFF)
-                return DeleteString(str, kInvalidUnicodeSurrogate);
+                return kInvalidUnicodeSurrogate;
               u1 = (((u1 - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
+            } else if(u1 >= 0xDC00 && u1 <= 0xDFFF &&
+              (flags & kParseValidateUtf8)) {
+              return kInvalidUnicodeSurrogate;
             }
             EncodeUtf8(str, u1);
             break;
           }
           default: {
-            return DeleteString(str, kInvalidStringEscape);
+            return kInvalidStringEscape;
           }
         }
         break;
       }
       default: {
         if((unsigned char)ch < 0x20)
-          return DeleteString(str, kInvalidStringChar);
+          return kInvalidStringChar;
         str->push_back(ch);
       }
     }
   }
 }
 
-ReturnValue Value::ParseString() {
-  Free();
-  ReturnValue result;
-  _value._string = new std::string();
-  result = ParseRawString(_value._string);
-  if(result == kOk) {
-    _type = kString;
+/*
+ * Parses a member key and the colon after it,
+ * into the key buffer of the frame.
+ */
+ReturnValue Value::ParseKey(
+  const char *&json,
+  std::string *key,
+  unsigned flags) {
+  if(*json != '"') {
+    return kMissKey;
   }
-  return result;
-}
-
-ReturnValue Value::ParseArray() {
-  _json++;
-  ReturnValue result;
-  Free();
-  _value._array = new std::vector<Value *>();
-  ParseWhitespace();
-  if(*_json == ']') {
-    _json++;
-    _type = kArray;
-    return kOk;
+  key->clear();
+  ReturnValue result = ParseRawString(json, key, flags);
+  if(result != kOk) {
+    return result;
   }
-  while(true) {
-    Value *element = new Value();
-    element->_json = _json;
-    result = element->ParseValue();
-    if(result != kOk) {
-      delete element;
-      break;
-    } else {
-      (_value._array)->push_back(element);
-      _json = element->_json;
-      ParseWhitespace();
-      if(*_json == ',') {
-        _json++;
-        ParseWhitespace();
-      } else if(*_json == ']') {
-        _json++;
-        _type = kArray;
-        return kOk;
-      } else {
-        result = kMissCommaOrSquareBracket;
-        break;
-      }
-    }
+  TINKER_PROFILE_KEY();
+  ParseWhitespace(json);
+  if(*json != ':') {
+    return kMissColon;
   }
-  size_t array_size = (_value._array)->size();
-  for(size_t i = 0; i < array_size; ++i) {
-    delete (_value._array)->at(i);
-  }
-  delete _value._array;
-  _value._array = nullptr;
-  return result;
+  json++;
+  ParseWhitespace(json);
+  return kOk;
 }
 
-ReturnValue Value::ParseObject() {
-  _json++;
-  ReturnValue result;
+ReturnValue Value::ParseString(
+  const char *&json,
+  ParserContext *context,
+  unsigned flags) {
   Free();
-  _value._object = new std::unordered_map<std::string, Value *>();
-  ParseWhitespace();
-  if(*_json == '}') {
-    _json++;
-    _type = kObject;
-    return kOk;
-  }
-  while(true) {
-    Value *element = new Value();
-    std::string key = "";
-
-    if(*_json != '"') {
-      result = kMissKey;
-      delete element;
-      break;
-    }
-    result = ParseRawString(&key);
-    if(result != kOk) {
-      delete element;
-      break;
-    }
-    ParseWhitespace();
-    if(*_json != ':') {
-      result = kMissColon;
-      delete element;
-      break;
-    }
-    _json++;
-    ParseWhitespace();
-    element->_json = _json;
-    result = element->ParseValue();
-    if(result != kOk) {
-      delete element;
-      break;
-    }
-    (_value._object)->insert({key, element});
-    _json = element->_json;
-    ParseWhitespace();
-    if(*_json == ',') {
-      _json++;
-      ParseWhitespace();
-    } else if(*_json == '}') {
-      _json++;
-      _type = kObject;
-      return kOk;
-    } else {
-      result = kMissCommaOrCurlyBracket;
-      break;
-    }
-  }
-  for(auto it = (_value._object)->begin();
-    it != (_value._object)->end();
-    ++it) {
-    delete it->second;
+  ReturnValue result;
+  _value._string = NewString(context);
+  result = ParseRawString(json, _value._string, flags);
+  if(result == kOk) {
+    _type = kString;
+    _flags |= (context == nullptr ? 0 : kFlagBorrowed);
+    TINKER_PROFILE_TOKEN(kString);
+  } else if(context == nullptr) {
+    delete _value._string;
+    _value._string = nullptr;
   }
-  delete _value._object;
-  _value._object = nullptr;
   return result;
 }
 }
@@ -0,0 +1,798 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerPatch.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerPatch.h"
+#include "source/TinkerPointer.h"
+#include "source/TinkerValue.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+/*
+ * Above this many cells, the table of the longest common subsequence
+ * is not built, and the elements left between the common prefix
+ * and suffix of two arrays are paired by index instead.
+ */
+static const size_t kMaxDiffCells = 1 << 22;
+
+// The index of a step of Diff() whose path has no token to append
+static const size_t kNoIndex = (size_t)-1;
+
+// Appends a reference token to a JSON Pointer, escaping ~ and /
+inline void AppendToken(std::string &path, const std::string &token) {
+  path.push_back('/');
+  for(size_t i = 0; i < token.length(); ++i) {
+    if(token[i] == '~') {
+      path += "~0";
+    } else if(token[i] == '/') {
+      path += "~1";
+    } else {
+      path.push_back(token[i]);
+    }
+  }
+}
+
+inline void AppendIndex(std::string &path, size_t index) {
+  path.push_back('/');
+  path += std::to_string(index);
+}
+
+/**
+ * Patcher
+ */
+
+/*
+ * Applies the operations of a patch one by one and records every
+ * change, so that a failed patch is rolled back change by change.
+ * A location is a member or an element of a container,
+ * or the document itself when there is no container.
+ * The nodes dropped by the patch are only deleted by Commit().
+ */
+class Patcher {
+ public:
+  explicit Patcher(Value &document) : _document(&document) {
+  }
+
+  ~Patcher() {
+    Rollback();
+  }
+
+  ReturnValue Apply(Value &operation);
+  void Commit();
+  void Rollback();
+
+  static bool IsContextOwned(const Value &value);
+  static bool CanMerge(const Value &document, const Value &patch);
+  static void Merge(Value &document, Value &patch);
+  static void Diff(
+    const Value &source,
+    const Value &target,
+    std::vector<Value *> &operations);
+  static Value* Copy(const Value &value);
+
+ private:
+  /*
+   * A step of Diff(): the nodes are diffed when op is null, otherwise
+   * the operation is emitted, with a copy of target if any. The path
+   * of a step is the first length characters of the path at hand,
+   * those of its parent, followed by key or index.
+   */
+  struct DiffStep {
+    DiffStep(
+      const char *op,
+      const Value *source,
+      const Value *target,
+      size_t length,
+      const std::string *key,
+      size_t index)
+      : op(op), source(source), target(target),
+        length(length), key(key), index(index) {}
+
+    const char *op;
+    const Value *source;
+    const Value *target;
+    size_t length;
+    const std::string *key;
+    size_t index;
+  };
+
+  struct Location {
+    Value *container;
+    std::string key;
+    size_t index;
+  };
+
+  struct Change {
+    enum Kind {
+      kAttach,  // The node was inserted at the location
+      kDetach,  // The node was removed from the location
+      kTake,    // The node was taken out of the operation
+      kCreate   // The node was copied by the patch
+    };
+
+    Kind kind;
+    Location location;
+    Value *node;
+    Value *operation;
+    bool drop;
+  };
+
+  static const Value* GetMember(const Value &object, const char *key);
+  static Value* GetChild(const Value &value, const std::string &token);
+  static Value* MakeOperation(
+    const char *name,
+    const std::string &path,
+    Value *value);
+  static void DiffObject(
+    const Value &source,
+    const Value &target,
+    size_t length,
+    std::vector<DiffStep> &steps);
+  static void DiffArray(
+    const Value &source,
+    const Value &target,
+    size_t length,
+    std::vector<DiffStep> &steps);
+  ReturnValue Resolve(
+    const Value &operation,
+    const char *member,
+    bool append,
+    Location &location) const;
+  Value* Find(const Location &location) const;
+  Value* Detach(const Location &location, bool drop);
+  void Attach(const Location &location, Value *node);
+  void Add(const Location &location, Value *node, bool replace);
+  void Record(Change::Kind kind, const Location &location, Value *node);
+
+  Value *_document;
+  std::vector<Change> _changes;
+};
+
+ReturnValue Patcher::Apply(Value &operation) {
+  if(operation._type != kObject) {
+    return kInvalidPatch;
+  }
+  const Value *op = GetMember(operation, "op");
+  if(op == nullptr || op->_type != kString) {
+    return kInvalidPatch;
+  }
+  const std::string &name = *(op->_value._string);
+  Location location;
+  ReturnValue result;
+  if(name == "add" || name == "replace" || name == "test") {
+    auto value = (operation._value._object)->find("value");
+    if(value == (operation._value._object)->end()) {
+      return kInvalidPatch;
+    }
+    result = Resolve(operation, "path", name == "add", location);
+    if(result != kOk) {
+      return result;
+    }
+    Value *target = Find(location);
+    if(name != "add" && target == nullptr) {
+      return kPathNotFound;
+    }
+    if(name == "test") {
+      return (*target == *(value->second) ? kOk : kPatchTestFailed);
+    }
+    Value *node = value->second;
+    (operation._value._object)->erase(value);
+    Change take = {Change::kTake, location, node, &operation, false};
+    _changes.push_back(take);
+    Add(location, node, name == "replace");
+    return kOk;
+  } else if(name == "remove") {
+    result = Resolve(operation, "path", false, location);
+    if(result != kOk) {
+      return result;
+    }
+    if(location.container == nullptr) {
+      return kInvalidPatch;
+    }
+    if(Find(location) == nullptr) {
+      return kPathNotFound;
+    }
+    Detach(location, true);
+    return kOk;
+  } else if(name == "move" || name == "copy") {
+    Location from;
+    result = Resolve(operation, "from", false, from);
+    if(result != kOk) {
+      return result;
+    }
+    const Value *path = GetMember(operation, "path");
+    if(path == nullptr || path->_type != kString) {
+      return kInvalidPatch;
+    }
+    Value *source = Find(from);
+    if(source == nullptr) {
+      return kPathNotFound;
+    }
+    Value *node;
+    if(name == "copy") {
+      node = Copy(*source);
+      Record(Change::kCreate, from, node);
+    } else {
+      // A subtree cannot move into itself
+      const std::string &to = *(path->_value._string);
+      std::string prefix = *(GetMember(operation, "from")->_value._string);
+      if(to == prefix) {
+        return kOk;
+      }
+      prefix.push_back('/');
+      if(to.compare(0, prefix.length(), prefix) == 0) {
+        return kInvalidPatch;
+      }
+      node = Detach(from, false);
+    }
+    result = Resolve(operation, "path", true, location);
+    if(result != kOk) {
+      return result;
+    }
+    Add(location, node, false);
+    return kOk;
+  }
+  return kInvalidPatch;
+}
+
+void Patcher::Commit() {
+  for(size_t i = 0; i < _changes.size(); ++i) {
+    const Change &change = _changes[i];
+    if(change.kind == Change::kDetach && change.drop) {
+      delete change.node;
+    } else if(change.kind == Change::kAttach &&
+      change.location.container == nullptr) {
+      // The node is left empty once swapped into the document
+      delete change.node;
+    }
+  }
+  _changes.clear();
+}
+
+void Patcher::Rollback() {
+  while(!_changes.empty()) {
+    const Change &change = _changes.back();
+    Value *container = change.location.container;
+    if(container != nullptr) {
+      container->MarkDirty();
+    }
+    switch(change.kind) {
+      case Change::kAttach: {
+        if(container == nullptr) {
+          _document->Swap(*(change.node));
+        } else if(container->_type == kObject) {
+          (container->_value._object)->erase(change.location.key);
+        } else {
+          std::vector<Value *> &array = *(container->_value._array);
+          array.erase(array.begin() + change.location.index);
+        }
+        break;
+      }
+      case Change::kDetach: {
+        if(container == nullptr) {
+          _document->Swap(*(change.node));
+          delete change.node;
+        } else if(container->_type == kObject) {
+          (container->_value._object)->emplace(
+            change.location.key, change.node);
+        } else {
+          std::vector<Value *> &array = *(container->_value._array);
+          array.insert(array.begin() + change.location.index, change.node);
+        }
+        break;
+      }
+      case Change::kTake: {
+        (change.operation->_value._object)->emplace("value", change.node);
+        break;
+      }
+      case Change::kCreate: {
+        delete change.node;
+        break;
+      }
+    }
+    _changes.pop_back();
+  }
+}
+
+/*
+ * The containers and strings of a tree parsed with a ParserContext are
+ * borrowed from it, and so are their children, which live in its chunks.
+ */
+bool Patcher::IsContextOwned(const Value &value) {
+  return (value._flags & Value::kFlagBorrowed) != 0;
+}
+
+/*
+ * Walks the nodes Merge() would swap or delete,
+ * none of which may be owned by a ParserContext.
+ */
+bool Patcher::CanMerge(const Value &document, const Value &patch) {
+  std::vector<std::pair<const Value *, const Value *> > stack;
+  stack.push_back(std::make_pair(&document, &patch));
+  while(!stack.empty()) {
+    const Value *target = stack.back().first;
+    const Value *source = stack.back().second;
+    stack.pop_back();
+    if(IsContextOwned(*target) || IsContextOwned(*source)) {
+      return false;
+    }
+    if(source->_type != kObject || target->_type != kObject) {
+      continue;
+    }
+    const std::unordered_map<std::string, Value *> &members =
+      *(target->_value._object);
+    for(auto it = (source->_value._object)->begin();
+      it != (source->_value._object)->end();
+      ++it) {
+      auto member = members.find(it->first);
+      if(member != members.end()) {
+        stack.push_back(std::make_pair(member->second, it->second));
+      } else if(IsContextOwned(*(it->second))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*
+ * Walks the patch and the document together without recursion.
+ * Every value which is not an object replaces its target,
+ * by swapping the payloads, which leaves null in the patch.
+ */
+void Patcher::Merge(Value &document, Value &patch) {
+  std::vector<std::pair<Value *, Value *> > stack;
+  stack.push_back(std::make_pair(&document, &patch));
+  while(!stack.empty()) {
+    Value *target = stack.back().first;
+    Value *source = stack.back().second;
+    stack.pop_back();
+    if(source->_type != kObject) {
+      target->Swap(*source);
+      source->Free();
+      continue;
+    }
+    if(target->_type != kObject) {
+      target->Free();
+      target->_value._object = new std::unordered_map<std::string, Value *>();
+      target->_type = kObject;
+    }
+    target->MarkDirty();
+    std::unordered_map<std::string, Value *> &members =
+      *(target->_value._object);
+    for(auto it = (source->_value._object)->begin();
+      it != (source->_value._object)->end();
+      ++it) {
+      auto member = members.find(it->first);
+      if(it->second->_type == kNull) {
+        if(member != members.end()) {
+          delete member->second;
+          members.erase(member);
+        }
+        continue;
+      }
+      if(member == members.end()) {
+        member = members.emplace(it->first, new Value()).first;
+      }
+      stack.push_back(std::make_pair(member->second, it->second));
+    }
+  }
+}
+
+/*
+ * Appends the operations turning source into target. The steps are
+ * kept on a stack, the steps of a container in reverse order,
+ * so the operations come out as a walk of the trees would emit them,
+ * without recursion. The path is shared by the steps.
+ */
+void Patcher::Diff(
+  const Value &source,
+  const Value &target,
+  std::vector<Value *> &operations) {
+  std::vector<DiffStep> stack;
+  std::vector<DiffStep> steps;
+  std::string path;
+  stack.push_back(DiffStep(nullptr, &source, &target, 0, nullptr, kNoIndex));
+  while(!stack.empty()) {
+    DiffStep step = stack.back();
+    stack.pop_back();
+    path.resize(step.length);
+    if(step.key != nullptr) {
+      AppendToken(path, *step.key);
+    } else if(step.index != kNoIndex) {
+      AppendIndex(path, step.index);
+    }
+    if(step.op != nullptr) {
+      Value *value = (step.target == nullptr ? nullptr : Copy(*step.target));
+      operations.push_back(MakeOperation(step.op, path, value));
+      continue;
+    }
+    const Value &from = *step.source;
+    const Value &to = *step.target;
+    if(from._type != to._type ||
+      (from._type != kArray && from._type != kObject)) {
+      if(from != to) {
+        operations.push_back(MakeOperation("replace", path, Copy(to)));
+      }
+      continue;
+    }
+    steps.clear();
+    if(from._type == kArray) {
+      DiffArray(from, to, path.length(), steps);
+    } else {
+      DiffObject(from, to, path.length(), steps);
+    }
+    stack.insert(stack.end(), steps.rbegin(), steps.rend());
+  }
+}
+
+// The members of source are diffed or removed, then the new ones added
+void Patcher::DiffObject(
+  const Value &source,
+  const Value &target,
+  size_t length,
+  std::vector<DiffStep> &steps) {
+  const std::unordered_map<std::string, Value *> &from =
+    *(source._value._object);
+  const std::unordered_map<std::string, Value *> &to =
+    *(target._value._object);
+  for(auto it = from.begin(); it != from.end(); ++it) {
+    auto other = to.find(it->first);
+    if(other == to.end()) {
+      steps.push_back(
+        DiffStep("remove", nullptr, nullptr, length, &(it->first), 0));
+    } else {
+      steps.push_back(DiffStep(
+        nullptr, it->second, other->second, length, &(it->first), 0));
+    }
+  }
+  for(auto it = to.begin(); it != to.end(); ++it) {
+    if(from.count(it->first) == 0) {
+      steps.push_back(
+        DiffStep("add", nullptr, it->second, length, &(it->first), 0));
+    }
+  }
+}
+
+/*
+ * The common prefix and suffix are skipped, the elements in between
+ * are matched on their longest common subsequence. Between two matches,
+ * the elements are diffed pairwise, then the extra ones are removed
+ * or added. The operations are emitted from left to right, the array
+ * being at any time the target up to j followed by the source from i,
+ * so the element at hand always has the index j.
+ */
+void Patcher::DiffArray(
+  const Value &source,
+  const Value &target,
+  size_t length,
+  std::vector<DiffStep> &steps) {
+  const std::vector<Value *> &from = *(source._value._array);
+  const std::vector<Value *> &to = *(target._value._array);
+  size_t n = from.size();
+  size_t m = to.size();
+  size_t prefix = 0;
+  while(prefix < n && prefix < m && *from[prefix] == *to[prefix]) {
+    prefix++;
+  }
+  size_t suffix = 0;
+  while(suffix < n - prefix && suffix < m - prefix &&
+    *from[n - 1 - suffix] == *to[m - 1 - suffix]) {
+    suffix++;
+  }
+
+  std::vector<std::pair<size_t, size_t> > matches;
+  size_t rows = n - prefix - suffix;
+  size_t columns = m - prefix - suffix;
+  if(rows > 0 && columns > 0 && (rows + 1) * (columns + 1) <= kMaxDiffCells) {
+    // lengths[i][j] is the length of the subsequence of the tails
+    size_t width = columns + 1;
+    std::vector<uint32_t> lengths((rows + 1) * width, 0);
+    for(size_t i = rows; i-- > 0;) {
+      for(size_t j = columns; j-- > 0;) {
+        if(*from[prefix + i] == *to[prefix + j]) {
+          lengths[i * width + j] = lengths[(i + 1) * width + j + 1] + 1;
+        } else {
+          lengths[i * width + j] = std::max(
+            lengths[(i + 1) * width + j], lengths[i * width + j + 1]);
+        }
+      }
+    }
+    size_t i = 0;
+    size_t j = 0;
+    while(i < rows && j < columns) {
+      if(lengths[i * width + j] == lengths[(i + 1) * width + j + 1] + 1 &&
+        *from[prefix + i] == *to[prefix + j]) {
+        matches.push_back(std::make_pair(prefix + i, prefix + j));
+        i++;
+        j++;
+      } else if(lengths[(i + 1) * width + j] >= lengths[i * width + j + 1]) {
+        i++;
+      } else {
+        j++;
+      }
+    }
+  }
+  matches.push_back(std::make_pair(n - suffix, m - suffix));
+
+  size_t i = prefix;
+  size_t j = prefix;
+  for(size_t k = 0; k < matches.size(); ++k) {
+    while(i < matches[k].first && j < matches[k].second) {
+      steps.push_back(DiffStep(nullptr, from[i], to[j], length, nullptr, j));
+      i++;
+      j++;
+    }
+    while(i < matches[k].first) {
+      steps.push_back(DiffStep("remove", nullptr, nullptr, length, nullptr, j));
+      i++;
+    }
+    while(j < matches[k].second) {
+      steps.push_back(DiffStep("add", nullptr, to[j], length, nullptr, j));
+      j++;
+    }
+    i++;
+    j++;
+  }
+}
+
+// A deep copy owning all its payloads, without recursion
+Value* Patcher::Copy(const Value &value) {
+  Value *root = new Value();
+  std::vector<std::pair<const Value *, Value *> > stack;
+  stack.push_back(std::make_pair(&value, root));
+  while(!stack.empty()) {
+    const Value *source = stack.back().first;
+    Value *copy = stack.back().second;
+    stack.pop_back();
+    copy->_type = source->_type;
+    copy->_flags = source->_flags &
+      (Value::kFlagInt64 | Value::kFlagUint64 | Value::kFlagRawNumber);
+    if(source->_type == kNumber) {
+      if(source->_flags & Value::kFlagRawNumber) {
+        copy->_value._raw = new RawNumber(*(source->_value._raw));
+      } else {
+        copy->_value = source->_value;
+      }
+    } else if(source->_type == kString) {
+      copy->_value._string = new std::string(*(source->_value._string));
+    } else if(source->_type == kArray) {
+      const std::vector<Value *> &array = *(source->_value._array);
+      copy->_value._array = new std::vector<Value *>(array.size());
+      for(size_t i = 0; i < array.size(); ++i) {
+        Value *element = new Value();
+        (*(copy->_value._array))[i] = element;
+        stack.push_back(std::make_pair(array[i], element));
+      }
+    } else if(source->_type == kObject) {
+      const std::unordered_map<std::string, Value *> &object =
+        *(source->_value._object);
+      copy->_value._object = new std::unordered_map<std::string, Value *>();
+      (copy->_value._object)->reserve(object.size());
+      for(auto it = object.begin(); it != object.end(); ++it) {
+        Value *member = new Value();
+        (copy->_value._object)->emplace(it->first, member);
+        stack.push_back(std::make_pair(it->second, member));
+      }
+    }
+  }
+  return root;
+}
+
+const Value* Patcher::GetMember(const Value &object, const char *key) {
+  auto it = (object._value._object)->find(key);
+  return (it == (object._value._object)->end() ? nullptr : it->second);
+}
+
+Value* Patcher::GetChild(const Value &value, const std::string &token) {
+  if(value._type == kObject) {
+    auto it = (value._value._object)->find(token);
+    return (it == (value._value._object)->end() ? nullptr : it->second);
+  } else if(value._type == kArray) {
+    size_t index;
+    if(ParseIndex(token, index) && index < (value._value._array)->size()) {
+      return (*(value._value._array))[index];
+    }
+  }
+  return nullptr;
+}
+
+Value* Patcher::MakeOperation(
+  const char *name,
+  const std::string &path,
+  Value *value) {
+  Value *operation = new Value();
+  operation->_value._object = new std::unordered_map<std::string, Value *>();
+  operation->_type = kObject;
+  std::unordered_map<std::string, Value *> &members =
+    *(operation->_value._object);
+  members["op"] = new Value();
+  members["op"]->SetString(name, strlen(name));
+  members["path"] = new Value();
+  members["path"]->SetString(path.data(), path.length());
+  if(value != nullptr) {
+    members["value"] = value;
+  }
+  return operation;
+}
+
+/*
+ * Finds the container of the location named by a pointer member
+ * of the operation. The last token must name an existing element
+ * of an array, or its end if append is set, while the member of
+ * an object may be missing.
+ */
+ReturnValue Patcher::Resolve(
+  const Value &operation,
+  const char *member,
+  bool append,
+  Location &location) const {
+  const Value *pointer = GetMember(operation, member);
+  if(pointer == nullptr || pointer->_type != kString) {
+    return kInvalidPatch;
+  }
+  std::vector<std::string> tokens;
+  if(!SplitPointer(*(pointer->_value._string), tokens)) {
+    return kInvalidPatch;
+  }
+  location.container = nullptr;
+  location.key.clear();
+  location.index = 0;
+  if(tokens.empty()) {
+    return kOk;
+  }
+  Value *current = _document;
+  for(size_t i = 0; i + 1 < tokens.size(); ++i) {
+    current = GetChild(*current, tokens[i]);
+    if(current == nullptr) {
+      return kPathNotFound;
+    }
+  }
+  const std::string &last = tokens.back();
+  if(current->_type == kObject) {
+    location.container = current;
+    location.key = last;
+    return kOk;
+  } else if(current->_type == kArray) {
+    size_t size = (current->_value._array)->size();
+    if(append && last == "-") {
+      location.index = size;
+    } else if(!ParseIndex(last, location.index) ||
+      location.index > size || (!append && location.index == size)) {
+      return kPathNotFound;
+    }
+    location.container = current;
+    return kOk;
+  }
+  return kPathNotFound;
+}
+
+Value* Patcher::Find(const Location &location) const {
+  Value *container = location.container;
+  if(container == nullptr) {
+    return _document;
+  } else if(container->_type == kObject) {
+    auto it = (container->_value._object)->find(location.key);
+    return (it == (container->_value._object)->end() ? nullptr : it->second);
+  }
+  std::vector<Value *> &array = *(container->_value._array);
+  return (location.index < array.size() ? array[location.index] : nullptr);
+}
+
+/*
+ * The document itself is detached into a new node,
+ * which takes its payload and leaves it null.
+ */
+Value* Patcher::Detach(const Location &location, bool drop) {
+  Value *container = location.container;
+  Value *node;
+  if(container == nullptr) {
+    node = new Value();
+    node->Swap(*_document);
+  } else if(container->_type == kObject) {
+    auto it = (container->_value._object)->find(location.key);
+    node = it->second;
+    (container->_value._object)->erase(it);
+  } else {
+    std::vector<Value *> &array = *(container->_value._array);
+    node = array[location.index];
+    array.erase(array.begin() + location.index);
+  }
+  if(container != nullptr) {
+    container->MarkDirty();
+  }
+  Change change = {Change::kDetach, location, node, nullptr, drop};
+  _changes.push_back(change);
+  return node;
+}
+
+void Patcher::Attach(const Location &location, Value *node) {
+  Value *container = location.container;
+  if(container == nullptr) {
+    _document->Swap(*node);
+  } else if(container->_type == kObject) {
+    (container->_value._object)->emplace(location.key, node);
+  } else {
+    std::vector<Value *> &array = *(container->_value._array);
+    array.insert(array.begin() + location.index, node);
+  }
+  if(container != nullptr) {
+    container->MarkDirty();
+  }
+  Record(Change::kAttach, location, node);
+}
+
+/*
+ * An existing member, or the document, is replaced,
+ * while an element is only replaced by replace and shifted by add.
+ */
+void Patcher::Add(const Location &location, Value *node, bool replace) {
+  if(location.container == nullptr || replace ||
+    (location.container->_type == kObject && Find(location) != nullptr)) {
+    Detach(location, true);
+  }
+  Attach(location, node);
+}
+
+void Patcher::Record(
+  Change::Kind kind,
+  const Location &location,
+  Value *node) {
+  Change change = {kind, location, node, nullptr, false};
+  _changes.push_back(change);
+}
+
+/**
+ * Patch functions
+ */
+
+ReturnValue ApplyPatch(Value &document, Value &patch) {
+  if(Patcher::IsContextOwned(document) || Patcher::IsContextOwned(patch)) {
+    return kContextOwned;
+  }
+  if(patch.GetType() != kArray) {
+    return kInvalidPatch;
+  }
+  Patcher patcher(document);
+  for(size_t i = 0; i < patch.GetArraySize(); ++i) {
+    ReturnValue result = patcher.Apply(patch[i]);
+    if(result != kOk) {
+      return result;
+    }
+  }
+  patcher.Commit();
+  return kOk;
+}
+
+ReturnValue ApplyMergePatch(Value &document, Value &patch) {
+  if(!Patcher::CanMerge(document, patch)) {
+    return kContextOwned;
+  }
+  Patcher::Merge(document, patch);
+  return kOk;
+}
+
+ReturnValue Diff(const Value &source, const Value &target, Value &patch) {
+  std::vector<Value *> operations;
+  Patcher::Diff(source, target, operations);
+  patch.SetArray(operations);
+  return kOk;
+}
+}
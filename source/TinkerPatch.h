@@ -0,0 +1,46 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerPatch.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_PATCH_H
+#define TINKER_JSON_PARSER_TINKER_PATCH_H
+
+#include "TinkerConstant.h"
+#include "TinkerValue.h"
+
+namespace Tinker {
+/*
+ * Applies a JSON Patch (RFC 6902), an array of operations,
+ * to the document in place. The nodes are moved: the values of
+ * the add and replace operations are taken out of the patch,
+ * move relinks the subtree, only copy duplicates it.
+ * Either every operation succeeds, or the document and the patch
+ * are both left as they were. Malformed operations return
+ * kInvalidPatch, missing locations kPathNotFound, and failed
+ * tests kPatchTestFailed. A tree parsed with a ParserContext, whose
+ * nodes the context owns, gives kContextOwned and is left untouched.
+ */
+ReturnValue ApplyPatch(Value &document, Value &patch);
+
+/*
+ * Applies a JSON Merge Patch (RFC 7396) in place,
+ * the values of the patch are moved into the document
+ * and leave null values behind them. Like ApplyPatch(), it gives
+ * kContextOwned for the trees parsed with a ParserContext.
+ */
+ReturnValue ApplyMergePatch(Value &document, Value &patch);
+
+/*
+ * Writes into patch the JSON Patch turning source into target.
+ * Equal subtrees give no operation, and arrays are matched on their
+ * longest common subsequence, so the patch grows with the changes
+ * rather than with the documents. The trees are walked without
+ * recursion, so their depth is not limited.
+ */
+ReturnValue Diff(const Value &source, const Value &target, Value &patch);
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_PATCH_H
@@ -0,0 +1,73 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerPointer.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_POINTER_H
+#define TINKER_JSON_PARSER_TINKER_POINTER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Tinker {
+/*
+ * JSON Pointer helpers shared by the patch functions and the
+ * ArrayReader, they are internal and not installed.
+ */
+
+/*
+ * Splits a JSON Pointer (RFC 6901) into its reference tokens,
+ * returns false if the pointer is malformed.
+ */
+inline bool SplitPointer(
+  const std::string &pointer,
+  std::vector<std::string> &tokens) {
+  tokens.clear();
+  if(pointer.empty()) {
+    return true;
+  }
+  if(pointer[0] != '/') {
+    return false;
+  }
+  for(size_t i = 0; i < pointer.length(); ++i) {
+    char ch = pointer[i];
+    if(ch == '/') {
+      tokens.push_back(std::string());
+    } else if(ch == '~') {
+      char next = (i + 1 < pointer.length() ? pointer[i + 1] : '\0');
+      if(next == '0') {
+        tokens.back().push_back('~');
+      } else if(next == '1') {
+        tokens.back().push_back('/');
+      } else {
+        return false;
+      }
+      ++i;
+    } else {
+      tokens.back().push_back(ch);
+    }
+  }
+  return true;
+}
+
+// An array index is 0 or digits without a leading zero
+inline bool ParseIndex(const std::string &token, size_t &index) {
+  if(token.empty() || token.length() > 18 ||
+    (token[0] == '0' && token.length() > 1)) {
+    return false;
+  }
+  index = 0;
+  for(size_t i = 0; i < token.length(); ++i) {
+    if(token[i] < '0' || token[i] > '9') {
+      return false;
+    }
+    index = index * 10 + (token[i] - '0');
+  }
+  return true;
+}
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_POINTER_H
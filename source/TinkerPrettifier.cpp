@@ -6,6 +6,7 @@
  */
 
 #include "source/TinkerConstant.h"
+#include "source/TinkerStream.h"
 #include "source/TinkerValue.h"
 
 #include <cerrno>
@@ -35,7 +36,7 @@ void Indent(std::string &text, int indent) {
  * the argument indent should be 0.
  */
 ReturnValue Value::Prettify(
-  std::string &text, int indent)  const {
+  std::string &text, int indent, unsigned flags)  const {
   std::string json;
   switch(_type) {
     case kNull: {
@@ -51,13 +52,13 @@ ReturnValue Value::Prettify(
       return StringifyNumber(text);
     }
     case kString: {
-      return StringifyString(text);
+      return StringifyString(text, flags);
     }
     case kArray: {
-      return PrettifyArray(text, indent);
+      return PrettifyArray(text, indent, flags);
     }
     case kObject: {
-      return PrettifyObject(text, indent);
+      return PrettifyObject(text, indent, flags);
     }
     default: {
       return kInvalidValue;
@@ -69,14 +70,17 @@ ReturnValue Value::Prettify(
  * The functions below are private.
  */
 
-ReturnValue Value::PrettifyArray(std::string &text, int indent) const {
+ReturnValue Value::PrettifyArray(
+  std::string &text,
+  int indent,
+  unsigned flags) const {
   text.push_back('[');
   if((_value._array)->size() > 0) {
     text.push_back('\n');
     size_t size = (_value._array)->size();
     for(size_t i = 0; i < size; ++i) {
       Indent(text, indent + 1);
-      (_value._array)->at(i)->Prettify(text, indent + 1);
+      (_value._array)->at(i)->Prettify(text, indent + 1, flags);
       text += ",\n";
     }
     text.pop_back();
@@ -88,7 +92,11 @@ ReturnValue Value::PrettifyArray(std::string &text, int indent) const {
   return kOk;
 }
 
-ReturnValue Value::PrettifyObject(std::string &text, int indent) const {
+ReturnValue Value::PrettifyObject(
+  std::string &text,
+  int indent,
+  unsigned flags) const {
+  Writer writer(text, flags);
   text.push_back('{');
   if((_value._object)->size() > 0) {
     text.push_back('\n');
@@ -96,11 +104,9 @@ ReturnValue Value::PrettifyObject(std::string &text, int indent) const {
       it != (_value._object)->end();
       ++it) {
       Indent(text, indent + 1);
-      text.push_back('"');
-      text += it->first;
-      text.push_back('"');
+      writer.String(it->first);
       text += ": ";
-      it->second->Prettify(text, indent + 1);
+      it->second->Prettify(text, indent + 1, flags);
       text += ",\n";
     }
     text.pop_back();
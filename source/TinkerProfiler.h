@@ -0,0 +1,54 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerProfiler.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_PROFILER_H
+#define TINKER_JSON_PARSER_TINKER_PROFILER_H
+
+#include "TinkerConstant.h"
+
+#include <cstdint>
+
+namespace Tinker {
+enum ParserPhase {
+  kPhaseParse,        // Whole Parse() calls
+  kPhaseWhitespace,   // ParseWhitespace()
+  kPhaseNumber,       // ParseNumber()
+  kPhaseString,       // ParseRawString(), for values and keys
+  kPhaseAllocation,   // Nodes, strings and containers
+  kPhaseCount
+};
+
+// Names of the phases, indexed by ParserPhase
+extern const char *PhaseString[kPhaseCount];
+
+/*
+ * Per-thread parser counters.
+ * They are only recorded when the library is compiled with
+ * TINKER_PARSER_PROFILING (cmake -DTINKER_PARSER_PROFILING=ON),
+ * otherwise the instrumentation compiles to nothing
+ * and the counters stay zero.
+ * Cycles come from the time stamp counter on x86,
+ * and are nanoseconds on the other architectures.
+ * The phases are timed independently, the time of Parse() not covered
+ * by the other phases is spent in the structural code.
+ */
+struct ParserStats {
+  ParserStats();
+
+  uint64_t cycles[kPhaseCount];  // Time spent in each phase
+  uint64_t bytes[kPhaseCount];   // Input consumed by each phase
+  uint64_t calls[kPhaseCount];   // Number of times each phase ran
+  uint64_t tokens[kObject + 1];  // Values parsed, by Type
+  uint64_t keys;                 // Object member keys parsed
+};
+
+bool IsParserProfilingEnabled();
+ParserStats GetParserStats();
+void ResetParserStats();
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_PROFILER_H
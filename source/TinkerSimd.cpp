@@ -0,0 +1,367 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerSimd.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerCpu.h"
+#include "source/TinkerSimd.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * The wider kernels are compiled for their instruction set with target
+ * attributes, whatever -march the library is built with, and only run
+ * once the CPU is known to support it.
+ */
+#if defined(__x86_64__) && defined(__SSE2__) && \
+  (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define TINKER_JSON_X86_DISPATCH 1
+#endif
+
+
+namespace Tinker {
+/**
+ * Baseline kernels
+ */
+
+static const char* ScanStringCharsBaseline(
+  const char *pointer,
+  const char *end) {
+  while(end - pointer >= 16) {
+    size_t index = FindStringChar16(pointer);
+    if(index < 16) {
+      return pointer + index;
+    }
+    pointer += 16;
+  }
+  return ScanStringCharsScalar(pointer, end);
+}
+
+static const char* ScanAsciiStringCharsBaseline(
+  const char *pointer,
+  const char *end) {
+  while(end - pointer >= 16) {
+    size_t index = FindAsciiStringChar16(pointer);
+    if(index < 16) {
+      return pointer + index;
+    }
+    pointer += 16;
+  }
+  return ScanAsciiStringCharsScalar(pointer, end);
+}
+
+static const char* ScanWhitespaceBaseline(const char *pointer, const char *end) {
+  while(end - pointer >= 16) {
+    size_t index = FindNonWhitespace16(pointer);
+    if(index < 16) {
+      return pointer + index;
+    }
+    pointer += 16;
+  }
+  return ScanWhitespaceScalar(pointer, end);
+}
+
+static const char* ScanInvalidUtf8Baseline(
+  const char *pointer,
+  const char *end) {
+  while(end - pointer >= 16 && CheckUtf8Chunk16(pointer, end)) {
+  }
+  return ScanInvalidUtf8Scalar(pointer, end);
+}
+
+#ifdef TINKER_JSON_X86_DISPATCH
+/**
+ * AVX2 kernels, 32 bytes at a time
+ */
+
+__attribute__((target("avx2")))
+static const char* ScanStringCharsAvx2(const char *pointer, const char *end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1F);
+  while(end - pointer >= 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)pointer);
+    __m256i special = _mm256_or_si256(
+      _mm256_or_si256(
+        _mm256_cmpeq_epi8(chunk, quote),
+        _mm256_cmpeq_epi8(chunk, backslash)),
+      _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(special);
+    if(mask != 0) {
+      return pointer + __builtin_ctz(mask);
+    }
+    pointer += 32;
+  }
+  return ScanStringCharsBaseline(pointer, end);
+}
+
+__attribute__((target("avx2")))
+static const char* ScanAsciiStringCharsAvx2(
+  const char *pointer,
+  const char *end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1F);
+  while(end - pointer >= 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)pointer);
+    __m256i special = _mm256_or_si256(
+      _mm256_or_si256(
+        _mm256_cmpeq_epi8(chunk, quote),
+        _mm256_cmpeq_epi8(chunk, backslash)),
+      _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(
+      _mm256_or_si256(special, chunk));
+    if(mask != 0) {
+      return pointer + __builtin_ctz(mask);
+    }
+    pointer += 32;
+  }
+  return ScanAsciiStringCharsBaseline(pointer, end);
+}
+
+__attribute__((target("avx2")))
+static const char* ScanWhitespaceAvx2(const char *pointer, const char *end) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i carriage = _mm256_set1_epi8('\r');
+  while(end - pointer >= 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)pointer);
+    __m256i whitespace = _mm256_or_si256(
+      _mm256_or_si256(
+        _mm256_cmpeq_epi8(chunk, space),
+        _mm256_cmpeq_epi8(chunk, tab)),
+      _mm256_or_si256(
+        _mm256_cmpeq_epi8(chunk, newline),
+        _mm256_cmpeq_epi8(chunk, carriage)));
+    unsigned mask = ~(unsigned)_mm256_movemask_epi8(whitespace);
+    if(mask != 0) {
+      return pointer + __builtin_ctz(mask);
+    }
+    pointer += 32;
+  }
+  return ScanWhitespaceBaseline(pointer, end);
+}
+
+// ASCII runs are skipped 32 bytes at a time, the rest is checked by 16
+__attribute__((target("avx2")))
+static const char* ScanInvalidUtf8Avx2(const char *pointer, const char *end) {
+  while(end - pointer >= 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)pointer);
+    if(_mm256_movemask_epi8(chunk) == 0) {
+      pointer += 32;
+    } else if(!CheckUtf8Chunk16(pointer, end)) {
+      return ScanInvalidUtf8Scalar(pointer, end);
+    }
+  }
+  return ScanInvalidUtf8Baseline(pointer, end);
+}
+
+/**
+ * AVX-512 kernels, 64 bytes at a time into mask registers
+ */
+
+__attribute__((target("avx512f,avx512bw")))
+static const char* ScanStringCharsAvx512(const char *pointer, const char *end) {
+  const __m512i quote = _mm512_set1_epi8('"');
+  const __m512i backslash = _mm512_set1_epi8('\\');
+  const __m512i space = _mm512_set1_epi8(0x20);
+  while(end - pointer >= 64) {
+    __m512i chunk = _mm512_loadu_si512((const void *)pointer);
+    uint64_t mask = _mm512_cmpeq_epi8_mask(chunk, quote) |
+      _mm512_cmpeq_epi8_mask(chunk, backslash) |
+      _mm512_cmplt_epu8_mask(chunk, space);
+    if(mask != 0) {
+      return pointer + __builtin_ctzll(mask);
+    }
+    pointer += 64;
+  }
+  return ScanStringCharsBaseline(pointer, end);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static const char* ScanAsciiStringCharsAvx512(
+  const char *pointer,
+  const char *end) {
+  const __m512i quote = _mm512_set1_epi8('"');
+  const __m512i backslash = _mm512_set1_epi8('\\');
+  const __m512i space = _mm512_set1_epi8(0x20);
+  while(end - pointer >= 64) {
+    __m512i chunk = _mm512_loadu_si512((const void *)pointer);
+    uint64_t mask = _mm512_cmpeq_epi8_mask(chunk, quote) |
+      _mm512_cmpeq_epi8_mask(chunk, backslash) |
+      _mm512_cmplt_epu8_mask(chunk, space) |
+      _mm512_movepi8_mask(chunk);
+    if(mask != 0) {
+      return pointer + __builtin_ctzll(mask);
+    }
+    pointer += 64;
+  }
+  return ScanAsciiStringCharsBaseline(pointer, end);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static const char* ScanWhitespaceAvx512(const char *pointer, const char *end) {
+  const __m512i space = _mm512_set1_epi8(' ');
+  const __m512i tab = _mm512_set1_epi8('\t');
+  const __m512i newline = _mm512_set1_epi8('\n');
+  const __m512i carriage = _mm512_set1_epi8('\r');
+  while(end - pointer >= 64) {
+    __m512i chunk = _mm512_loadu_si512((const void *)pointer);
+    uint64_t mask = ~(_mm512_cmpeq_epi8_mask(chunk, space) |
+      _mm512_cmpeq_epi8_mask(chunk, tab) |
+      _mm512_cmpeq_epi8_mask(chunk, newline) |
+      _mm512_cmpeq_epi8_mask(chunk, carriage));
+    if(mask != 0) {
+      return pointer + __builtin_ctzll(mask);
+    }
+    pointer += 64;
+  }
+  return ScanWhitespaceBaseline(pointer, end);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static const char* ScanInvalidUtf8Avx512(const char *pointer, const char *end) {
+  while(end - pointer >= 64) {
+    __m512i chunk = _mm512_loadu_si512((const void *)pointer);
+    if(_mm512_movepi8_mask(chunk) == 0) {
+      pointer += 64;
+    } else if(!CheckUtf8Chunk16(pointer, end)) {
+      return ScanInvalidUtf8Scalar(pointer, end);
+    }
+  }
+  return ScanInvalidUtf8Baseline(pointer, end);
+}
+#endif
+
+/**
+ * Kernel tables
+ */
+
+static const SimdKernels kScalarKernels = {
+  kSimdScalar,
+  ScanStringCharsScalar,
+  ScanAsciiStringCharsScalar,
+  ScanWhitespaceScalar,
+  ScanInvalidUtf8Scalar
+};
+
+// The kernels of the instructions every CPU of the target has
+static const SimdKernels kBaselineKernels = {
+#ifdef __SSE2__
+  kSimdSse2,
+#elif defined(TINKER_JSON_NEON)
+  kSimdNeon,
+#else
+  kSimdScalar,
+#endif
+  ScanStringCharsBaseline,
+  ScanAsciiStringCharsBaseline,
+  ScanWhitespaceBaseline,
+  ScanInvalidUtf8Baseline
+};
+
+#ifdef TINKER_JSON_X86_DISPATCH
+static const SimdKernels kAvx2Kernels = {
+  kSimdAvx2,
+  ScanStringCharsAvx2,
+  ScanAsciiStringCharsAvx2,
+  ScanWhitespaceAvx2,
+  ScanInvalidUtf8Avx2
+};
+
+static const SimdKernels kAvx512Kernels = {
+  kSimdAvx512,
+  ScanStringCharsAvx512,
+  ScanAsciiStringCharsAvx512,
+  ScanWhitespaceAvx512,
+  ScanInvalidUtf8Avx512
+};
+#endif
+
+// Constant initialized, so kernels used before the detection work
+std::atomic<const SimdKernels *> gSimdKernels(&kBaselineKernels);
+
+static const SimdKernels* FindKernels(SimdLevel level) {
+  if(level == kScalarKernels.level) {
+    return &kScalarKernels;
+  } else if(level == kBaselineKernels.level) {
+    return &kBaselineKernels;
+  }
+#ifdef TINKER_JSON_X86_DISPATCH
+  if(level == kSimdAvx2) {
+    return &kAvx2Kernels;
+  } else if(level == kSimdAvx512) {
+    return &kAvx512Kernels;
+  }
+#endif
+  return nullptr;
+}
+
+/*
+ * The CPU reports AVX2 and AVX-512 only when the system saves their
+ * registers, which __builtin_cpu_supports() also checks.
+ */
+static SimdLevel DetectSimdLevel() {
+#ifdef TINKER_JSON_X86_DISPATCH
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512bw")) {
+    return kSimdAvx512;
+  }
+  if(__builtin_cpu_supports("avx2")) {
+    return kSimdAvx2;
+  }
+#endif
+  return kBaselineKernels.level;
+}
+
+// Selects the kernels when the library is loaded
+static const bool gSimdSelected = SetSimdLevel(DetectSimdLevel());
+
+/**
+ * Dispatch functions
+ */
+
+const char *SimdLevelString[kSimdNeon + 1] = {
+  "scalar",
+  "sse2",
+  "avx2",
+  "avx512",
+  "neon"
+};
+
+bool IsSimdLevelSupported(SimdLevel level) {
+  if(FindKernels(level) == nullptr) {
+    return false;
+  }
+#ifdef TINKER_JSON_X86_DISPATCH
+  if(level == kSimdAvx512) {
+    return (DetectSimdLevel() == kSimdAvx512);
+  } else if(level == kSimdAvx2) {
+    return (DetectSimdLevel() >= kSimdAvx2);
+  }
+#endif
+  return true;
+}
+
+SimdLevel GetBestSimdLevel() {
+  return DetectSimdLevel();
+}
+
+SimdLevel GetSimdLevel() {
+  return GetSimdKernels().level;
+}
+
+bool SetSimdLevel(SimdLevel level) {
+  if(!IsSimdLevelSupported(level)) {
+    return false;
+  }
+  gSimdKernels.store(FindKernels(level), std::memory_order_relaxed);
+  return true;
+}
+}
@@ -0,0 +1,364 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerSimd.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_SIMD_H
+#define TINKER_JSON_PARSER_TINKER_SIMD_H
+
+#include "TinkerCpu.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TINKER_JSON_NEON 1
+#endif
+
+namespace Tinker {
+/*
+ * Scanning kernels shared by the library, they are internal
+ * and not installed. Each kernel reads only inside [pointer, end).
+ * The first 16 bytes are checked inline with the baseline vectors of
+ * the build, SSE2 or NEON, since most strings and whitespace runs end
+ * there. Longer scans go on in the kernels of the level selected at
+ * load time, see TinkerCpu.h and TinkerSimd.cpp.
+ */
+
+typedef const char* (*ScanFunction)(const char *pointer, const char *end);
+
+struct SimdKernels {
+  SimdLevel level;
+  ScanFunction scan_string_chars;
+  ScanFunction scan_ascii_string_chars;
+  ScanFunction scan_whitespace;
+  ScanFunction scan_invalid_utf8;
+};
+
+extern std::atomic<const SimdKernels *> gSimdKernels;
+
+inline const SimdKernels& GetSimdKernels() {
+  return *gSimdKernels.load(std::memory_order_relaxed);
+}
+
+/**
+ * Scalar loops, for the tails of the vector loops
+ */
+
+inline bool IsStringChar(char ch) {
+  return (ch != '"' && ch != '\\' && (unsigned char)ch >= 0x20);
+}
+
+inline bool IsWhitespace(char ch) {
+  return (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r');
+}
+
+inline const char* ScanStringCharsScalar(const char *pointer, const char *end) {
+  while(pointer < end && IsStringChar(*pointer)) {
+    ++pointer;
+  }
+  return pointer;
+}
+
+inline const char* ScanAsciiStringCharsScalar(
+  const char *pointer,
+  const char *end) {
+  while(pointer < end && IsStringChar(*pointer) &&
+    (unsigned char)*pointer < 0x80) {
+    ++pointer;
+  }
+  return pointer;
+}
+
+inline const char* ScanWhitespaceScalar(const char *pointer, const char *end) {
+  while(pointer < end && IsWhitespace(*pointer)) {
+    ++pointer;
+  }
+  return pointer;
+}
+
+/*
+ * Length of the UTF-8 sequence at pointer, or 0 if it is invalid:
+ * overlong forms, surrogates, code points above U+10FFFF
+ * and sequences cut by end are all rejected.
+ */
+inline size_t Utf8SequenceLength(const char *pointer, const char *end) {
+  const unsigned char *bytes = (const unsigned char *)pointer;
+  unsigned char lead = bytes[0];
+  unsigned char low = 0x80, high = 0xBF;
+  size_t length;
+  if(lead < 0x80) {
+    return 1;
+  } else if(lead < 0xC2) {
+    return 0;
+  } else if(lead < 0xE0) {
+    length = 2;
+  } else if(lead < 0xF0) {
+    length = 3;
+    if(lead == 0xE0) low = 0xA0;
+    if(lead == 0xED) high = 0x9F;
+  } else if(lead < 0xF5) {
+    length = 4;
+    if(lead == 0xF0) low = 0x90;
+    if(lead == 0xF4) high = 0x8F;
+  } else {
+    return 0;
+  }
+  if((size_t)(end - pointer) < length || bytes[1] < low || bytes[1] > high) {
+    return 0;
+  }
+  for(size_t i = 2; i < length; ++i) {
+    if((bytes[i] & 0xC0) != 0x80) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+inline const char* ScanInvalidUtf8Scalar(const char *pointer, const char *end) {
+  while(pointer < end) {
+    size_t length = Utf8SequenceLength(pointer, end);
+    if(length == 0) {
+      break;
+    }
+    pointer += length;
+  }
+  return pointer;
+}
+
+/**
+ * Baseline vectors, 16 bytes at a time
+ */
+
+#ifdef TINKER_JSON_NEON
+// One nibble per byte of a comparison result, the first match is ctz / 4
+inline uint64_t NeonMask(uint8x16_t matches) {
+  return vget_lane_u64(vreinterpret_u64_u8(
+    vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+}
+
+inline size_t NeonIndex(uint8x16_t matches) {
+  uint64_t mask = NeonMask(matches);
+  return (mask == 0 ? 16 : __builtin_ctzll(mask) >> 2);
+}
+#endif
+
+// Index of the first quotation mark, backslash or control character, or 16
+inline size_t FindStringChar16(const char *pointer) {
+#ifdef __SSE2__
+  __m128i chunk = _mm_loadu_si128((const __m128i *)pointer);
+  __m128i special = _mm_or_si128(
+    _mm_or_si128(
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+    _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk));
+  int mask = _mm_movemask_epi8(special);
+  return (mask == 0 ? 16 : __builtin_ctz(mask));
+#elif defined(TINKER_JSON_NEON)
+  uint8x16_t chunk = vld1q_u8((const uint8_t *)pointer);
+  return NeonIndex(vorrq_u8(
+    vorrq_u8(
+      vceqq_u8(chunk, vdupq_n_u8('"')),
+      vceqq_u8(chunk, vdupq_n_u8('\\'))),
+    vcltq_u8(chunk, vdupq_n_u8(0x20))));
+#else
+  return ScanStringCharsScalar(pointer, pointer + 16) - pointer;
+#endif
+}
+
+// The same, and bytes above 0x7F
+inline size_t FindAsciiStringChar16(const char *pointer) {
+#ifdef __SSE2__
+  __m128i chunk = _mm_loadu_si128((const __m128i *)pointer);
+  __m128i special = _mm_or_si128(
+    _mm_or_si128(
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+    _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk));
+  // The sign bits of the chunk are the bytes above 0x7F
+  int mask = _mm_movemask_epi8(_mm_or_si128(special, chunk));
+  return (mask == 0 ? 16 : __builtin_ctz(mask));
+#elif defined(TINKER_JSON_NEON)
+  uint8x16_t chunk = vld1q_u8((const uint8_t *)pointer);
+  return NeonIndex(vorrq_u8(
+    vorrq_u8(
+      vceqq_u8(chunk, vdupq_n_u8('"')),
+      vceqq_u8(chunk, vdupq_n_u8('\\'))),
+    vorrq_u8(
+      vcltq_u8(chunk, vdupq_n_u8(0x20)),
+      vcgeq_u8(chunk, vdupq_n_u8(0x80)))));
+#else
+  return ScanAsciiStringCharsScalar(pointer, pointer + 16) - pointer;
+#endif
+}
+
+// Index of the first character which is not JSON whitespace, or 16
+inline size_t FindNonWhitespace16(const char *pointer) {
+#ifdef __SSE2__
+  __m128i chunk = _mm_loadu_si128((const __m128i *)pointer);
+  __m128i whitespace = _mm_or_si128(
+    _mm_or_si128(
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+    _mm_or_si128(
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+  int mask = _mm_movemask_epi8(whitespace) ^ 0xFFFF;
+  return (mask == 0 ? 16 : __builtin_ctz(mask));
+#elif defined(TINKER_JSON_NEON)
+  uint8x16_t chunk = vld1q_u8((const uint8_t *)pointer);
+  return NeonIndex(vmvnq_u8(vorrq_u8(
+    vorrq_u8(
+      vceqq_u8(chunk, vdupq_n_u8(' ')),
+      vceqq_u8(chunk, vdupq_n_u8('\t'))),
+    vorrq_u8(
+      vceqq_u8(chunk, vdupq_n_u8('\n')),
+      vceqq_u8(chunk, vdupq_n_u8('\r'))))));
+#else
+  return ScanWhitespaceScalar(pointer, pointer + 16) - pointer;
+#endif
+}
+
+/*
+ * Checks the 16 bytes at pointer for invalid UTF-8, and moves it past
+ * them, or to the lead of a sequence cut by their end. Returns false
+ * if a sequence is invalid: the scalar loop then finds the exact one.
+ *
+ * With SSE2, a chunk without any byte above 0x7F is skipped at once.
+ * Otherwise the bytes are classified into bit masks: every lead byte
+ * requires continuation bytes right after it, which must be exactly
+ * the continuation bytes found, and the leads with a narrower range
+ * for their second byte are checked against it.
+ */
+inline bool CheckUtf8Chunk16(const char *&pointer, const char *end) {
+#ifdef __SSE2__
+  (void)end;
+  __m128i chunk = _mm_loadu_si128((const __m128i *)pointer);
+  unsigned non_ascii = _mm_movemask_epi8(chunk);
+  if(non_ascii == 0) {
+    pointer += 16;
+    return true;
+  }
+  // As signed bytes, 0x80 ... 0xFF are the ordered range -128 ... -1
+  unsigned continuation = _mm_movemask_epi8(
+    _mm_cmplt_epi8(chunk, _mm_set1_epi8(-64)));
+  unsigned lead2 = _mm_movemask_epi8(_mm_and_si128(
+    _mm_cmpgt_epi8(chunk, _mm_set1_epi8(-63)),
+    _mm_cmplt_epi8(chunk, _mm_set1_epi8(-32))));
+  unsigned lead3 = _mm_movemask_epi8(_mm_and_si128(
+    _mm_cmpgt_epi8(chunk, _mm_set1_epi8(-33)),
+    _mm_cmplt_epi8(chunk, _mm_set1_epi8(-16))));
+  unsigned lead4 = _mm_movemask_epi8(_mm_and_si128(
+    _mm_cmpgt_epi8(chunk, _mm_set1_epi8(-17)),
+    _mm_cmplt_epi8(chunk, _mm_set1_epi8(-11))));
+  unsigned leads = lead2 | lead3 | lead4;
+  unsigned invalid = non_ascii & ~(continuation | leads);
+
+  unsigned required = (leads << 1) | ((lead3 | lead4) << 2) | (lead4 << 3);
+  invalid |= (required & 0xFFFF) ^ continuation;
+
+  unsigned e0 = _mm_movemask_epi8(
+    _mm_cmpeq_epi8(chunk, _mm_set1_epi8((char)0xE0)));
+  unsigned ed = _mm_movemask_epi8(
+    _mm_cmpeq_epi8(chunk, _mm_set1_epi8((char)0xED)));
+  unsigned f0 = _mm_movemask_epi8(
+    _mm_cmpeq_epi8(chunk, _mm_set1_epi8((char)0xF0)));
+  unsigned f4 = _mm_movemask_epi8(
+    _mm_cmpeq_epi8(chunk, _mm_set1_epi8((char)0xF4)));
+  unsigned below_a0 = _mm_movemask_epi8(
+    _mm_cmplt_epi8(chunk, _mm_set1_epi8((char)0xA0)));
+  unsigned above_9f = _mm_movemask_epi8(
+    _mm_cmpgt_epi8(chunk, _mm_set1_epi8((char)0x9F)));
+  unsigned below_90 = _mm_movemask_epi8(
+    _mm_cmplt_epi8(chunk, _mm_set1_epi8((char)0x90)));
+  unsigned above_8f = _mm_movemask_epi8(
+    _mm_cmpgt_epi8(chunk, _mm_set1_epi8((char)0x8F)));
+  invalid |= ((e0 << 1) & below_a0) | ((ed << 1) & above_9f) |
+    ((f0 << 1) & below_90) | ((f4 << 1) & above_8f);
+
+  if(invalid != 0) {
+    return false;
+  }
+  if((required >> 16) != 0) {
+    // Restart on the lead of the sequence cut by the end of the chunk
+    pointer += 31 - __builtin_clz(leads);
+  } else {
+    pointer += 16;
+  }
+  return true;
+#else
+#ifdef TINKER_JSON_NEON
+  if(vmaxvq_u8(vld1q_u8((const uint8_t *)pointer)) < 0x80) {
+    pointer += 16;
+    return true;
+  }
+#endif
+  // Whole sequences starting in the chunk, which may end past it
+  const char *chunk_end = pointer + 16;
+  while(pointer < chunk_end) {
+    size_t length = Utf8SequenceLength(pointer, end);
+    if(length == 0) {
+      return false;
+    }
+    pointer += length;
+  }
+  return true;
+#endif
+}
+
+/**
+ * Entry points
+ */
+
+// First quotation mark, backslash or control character, or end
+inline const char* ScanStringChars(const char *pointer, const char *end) {
+  if(end - pointer < 16) {
+    return ScanStringCharsScalar(pointer, end);
+  }
+  size_t index = FindStringChar16(pointer);
+  if(index < 16) {
+    return pointer + index;
+  }
+  return GetSimdKernels().scan_string_chars(pointer + 16, end);
+}
+
+/*
+ * First quotation mark, backslash, control character
+ * or byte above 0x7F, or end
+ */
+inline const char* ScanAsciiStringChars(const char *pointer, const char *end) {
+  if(end - pointer < 16) {
+    return ScanAsciiStringCharsScalar(pointer, end);
+  }
+  size_t index = FindAsciiStringChar16(pointer);
+  if(index < 16) {
+    return pointer + index;
+  }
+  return GetSimdKernels().scan_ascii_string_chars(pointer + 16, end);
+}
+
+// First character which is not JSON whitespace, or end
+inline const char* ScanWhitespace(const char *pointer, const char *end) {
+  if(end - pointer < 16) {
+    return ScanWhitespaceScalar(pointer, end);
+  }
+  size_t index = FindNonWhitespace16(pointer);
+  if(index < 16) {
+    return pointer + index;
+  }
+  return GetSimdKernels().scan_whitespace(pointer + 16, end);
+}
+
+// First byte of an invalid UTF-8 sequence, or end
+inline const char* ScanInvalidUtf8(const char *pointer, const char *end) {
+  return GetSimdKernels().scan_invalid_utf8(pointer, end);
+}
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_SIMD_H
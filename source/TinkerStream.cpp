@@ -0,0 +1,727 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerStream.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerPointer.h"
+#include "source/TinkerSimd.h"
+#include "source/TinkerStream.h"
+#include "source/TinkerValidator.h"
+#include "source/TinkerValue.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+// The size of the reads of an ArrayReader, which grows with the elements
+static const size_t kChunkSize = 64 * 1024;
+
+/**
+ * Reader
+ */
+
+Reader::Reader(const char *json)
+  : _begin(json),
+    _end(json + strlen(json)),
+    _json(json),
+    _first(false),
+    _depth(0) {
+}
+
+ReturnValue Reader::ReadNull() {
+  Value::ParseWhitespace(_json);
+  if(*_json != 'n') {
+    return Unexpected();
+  }
+  Value literal;
+  return literal.ParseLiteral(_json, "null", kNull);
+}
+
+ReturnValue Reader::ReadBoolean(bool &boolean) {
+  Value::ParseWhitespace(_json);
+  Value literal;
+  ReturnValue result;
+  if(*_json == 't') {
+    result = literal.ParseLiteral(_json, "true", kTrue);
+  } else if(*_json == 'f') {
+    result = literal.ParseLiteral(_json, "false", kFalse);
+  } else {
+    return Unexpected();
+  }
+  if(result == kOk) {
+    boolean = (literal._type == kTrue);
+  }
+  return result;
+}
+
+ReturnValue Reader::ReadNumber(NumberValue &number) {
+  Value::ParseWhitespace(_json);
+  if(*_json != '-' && (*_json < '0' || *_json > '9')) {
+    return Unexpected();
+  }
+  Value parsed;
+  ReturnValue result = parsed.ParseNumber(_json, nullptr, kParseDefault);
+  if(result == kOk) {
+    number = parsed.ReadNumber();
+  }
+  return result;
+}
+
+ReturnValue Reader::ReadString(std::string &str) {
+  Value::ParseWhitespace(_json);
+  if(*_json != '"') {
+    return Unexpected();
+  }
+  str.clear();
+  return Value::ParseRawString(_json, &str, kParseDefault);
+}
+
+ReturnValue Reader::ReadValue(Value &value) {
+  Value::ParseWhitespace(_json);
+  value.Free();
+  return value.ParseValue(
+    _json, nullptr, kParseDefault, _stack, kDefaultMaxDepth - _depth);
+}
+
+// Skipped values are only validated, which allocates nothing
+ReturnValue Reader::SkipValue() {
+  Value::ParseWhitespace(_json);
+  return ValidateValue(_json, _end, kDefaultMaxDepth - _depth);
+}
+
+ReturnValue Reader::StartArray() {
+  return StartContainer('[');
+}
+
+/*
+ * Only one flag is needed for the first element:
+ * a nested container is always complete when the next
+ * element of its parent is read.
+ */
+ReturnValue Reader::NextElement(bool &more) {
+  Value::ParseWhitespace(_json);
+  if(_first) {
+    _first = false;
+    more = (*_json != ']');
+  } else if(*_json == ',') {
+    _json++;
+    more = true;
+  } else if(*_json == ']') {
+    more = false;
+  } else {
+    return kMissCommaOrSquareBracket;
+  }
+  if(!more) {
+    _json++;
+    _depth--;
+  }
+  return kOk;
+}
+
+ReturnValue Reader::StartObject() {
+  return StartContainer('{');
+}
+
+ReturnValue Reader::NextMember(bool &more) {
+  Value::ParseWhitespace(_json);
+  if(_first) {
+    _first = false;
+    more = (*_json != '}');
+  } else if(*_json == ',') {
+    _json++;
+    Value::ParseWhitespace(_json);
+    more = true;
+  } else if(*_json == '}') {
+    more = false;
+  } else {
+    return kMissCommaOrCurlyBracket;
+  }
+  if(!more) {
+    _json++;
+    _depth--;
+    return kOk;
+  }
+  return Value::ParseKey(_json, &_key, kParseDefault);
+}
+
+const std::string& Reader::GetKey() const {
+  return _key;
+}
+
+ReturnValue Reader::Finish() {
+  Value::ParseWhitespace(_json);
+  return (*_json == '\0' ? kOk : kNotSingular);
+}
+
+size_t Reader::GetOffset() const {
+  return _json - _begin;
+}
+
+/*
+ * A value of another type is a mismatch,
+ * anything else is reported as the parser would.
+ */
+ReturnValue Reader::Unexpected() const {
+  switch(*_json) {
+    case 'n':
+    case 't':
+    case 'f':
+    case '"':
+    case '[':
+    case '{':
+    case '-': return kTypeMismatch;
+    case '\0': return kExpectValue;
+    default: {
+      return (*_json >= '0' && *_json <= '9') ? kTypeMismatch : kInvalidValue;
+    }
+  }
+}
+
+ReturnValue Reader::StartContainer(char opening) {
+  Value::ParseWhitespace(_json);
+  if(*_json != opening) {
+    return Unexpected();
+  }
+  if(_depth == kDefaultMaxDepth) {
+    return kDepthLimitExceeded;
+  }
+  _json++;
+  _depth++;
+  _first = true;
+  return kOk;
+}
+
+/**
+ * ArrayReader
+ */
+
+ArrayReader::ArrayReader(
+  const char *json,
+  const std::string &pointer,
+  unsigned flags)
+  : _data(json),
+    _size(strlen(json)),
+    _cursor(0),
+    _consumed(0),
+    _eof(true),
+    _pointer(pointer),
+    _flags(flags),
+    _depth(0),
+    _opened(false),
+    _first(false),
+    _done(false),
+    _result(kOk) {
+}
+
+ArrayReader::ArrayReader(
+  const ReadFunction &read,
+  const std::string &pointer,
+  unsigned flags)
+  : _read(read),
+    _data(""),
+    _size(0),
+    _cursor(0),
+    _consumed(0),
+    _eof(false),
+    _pointer(pointer),
+    _flags(flags),
+    _depth(0),
+    _opened(false),
+    _first(false),
+    _done(false),
+    _result(kOk) {
+}
+
+/*
+ * The previous element is freed first. Read in chunks, an element
+ * is validated before it is parsed, which finds its end without
+ * allocating: it is only parsed once all of it is in the buffer.
+ */
+bool ArrayReader::Next(Value &value) {
+  value.Free();
+  if(_done || _result != kOk) {
+    return false;
+  }
+  if(!_opened) {
+    _opened = true;
+    if(Fail(Open()) != kOk) {
+      return false;
+    }
+  }
+  char ch = Peek();
+  if(_first) {
+    _first = false;
+  } else if(ch == ',') {
+    _cursor++;
+    ch = Peek();
+    // A comma before the closing bracket, which Parse() rejects too
+    if(ch == ']') {
+      Fail(kInvalidValue);
+      return false;
+    }
+  } else if(ch != ']') {
+    Fail(kMissCommaOrSquareBracket);
+    return false;
+  }
+  if(ch == ']') {
+    _cursor++;
+    _done = true;
+    return false;
+  }
+
+  size_t length = 0;
+  if(_read) {
+    if(Fail(Measure(length)) != kOk) {
+      return false;
+    }
+    const char *begin = _data + _cursor;
+    if((_flags & kParseValidateUtf8) &&
+      ScanInvalidUtf8(begin, begin + length) != begin + length) {
+      Fail(kInvalidUtf8);
+      return false;
+    }
+  }
+  const char *json = _data + _cursor;
+  ReturnValue result = value.ParseValue(
+    json, nullptr, _flags, _stack, kDefaultMaxDepth - _depth);
+  _cursor = json - _data;
+  if(Fail(result) != kOk) {
+    value.Free();
+    return false;
+  }
+  return true;
+}
+
+ReturnValue ArrayReader::GetResult() const {
+  return _result;
+}
+
+size_t ArrayReader::GetOffset() const {
+  return _consumed + _cursor;
+}
+
+ArrayReader::Iterator ArrayReader::begin() {
+  return Iterator(this);
+}
+
+ArrayReader::Iterator ArrayReader::end() {
+  return Iterator();
+}
+
+// Skips whitespace, reading chunks as needed, '\0' at the end of the text
+char ArrayReader::Peek() {
+  while(true) {
+    while(_cursor < _size && (_data[_cursor] == ' ' ||
+      _data[_cursor] == '\t' || _data[_cursor] == '\n' ||
+      _data[_cursor] == '\r')) {
+      _cursor++;
+    }
+    if(_cursor < _size) {
+      return _data[_cursor];
+    }
+    if(!Fill()) {
+      return '\0';
+    }
+  }
+}
+
+/*
+ * Drops the bytes before the cursor and appends a chunk.
+ * The chunk is as large as what is kept, so an element larger
+ * than a chunk is read in a number of steps logarithmic in its size.
+ */
+bool ArrayReader::Fill() {
+  if(_eof) {
+    return false;
+  }
+  _buffer.erase(0, _cursor);
+  _consumed += _cursor;
+  _cursor = 0;
+  size_t kept = _buffer.length();
+  size_t size = std::max(kChunkSize, kept);
+  _buffer.resize(kept + size);
+  size_t count = _read(&_buffer[kept], size);
+  _buffer.resize(kept + std::min(count, size));
+  _data = _buffer.c_str();
+  _size = _buffer.length();
+  if(count == 0) {
+    _eof = true;
+  }
+  return count != 0;
+}
+
+/*
+ * Follows the pointer to the array, skipping the other values,
+ * and leaves the cursor on its first element.
+ */
+ReturnValue ArrayReader::Open() {
+  if(!_read && (_flags & kParseValidateUtf8) &&
+    ScanInvalidUtf8(_data, _data + _size) != _data + _size) {
+    return kInvalidUtf8;
+  }
+  std::vector<std::string> tokens;
+  if(!SplitPointer(_pointer, tokens)) {
+    return kPathNotFound;
+  }
+  for(size_t t = 0; t <= tokens.size(); ++t) {
+    char ch = Peek();
+    if(ch == '\0') {
+      return kExpectValue;
+    }
+    if(_depth == kDefaultMaxDepth && (ch == '[' || ch == '{')) {
+      return kDepthLimitExceeded;
+    }
+    if(t == tokens.size()) {
+      if(ch != '[') {
+        return kTypeMismatch;
+      }
+      _cursor++;
+      _depth++;
+      _first = true;
+      return kOk;
+    }
+
+    size_t index = 0;
+    if(ch == '[') {
+      if(!ParseIndex(tokens[t], index)) {
+        return kPathNotFound;
+      }
+    } else if(ch != '{') {
+      return kPathNotFound;
+    }
+    bool object = (ch == '{');
+    _cursor++;
+    _depth++;
+    for(size_t i = 0; ; ++i) {
+      ch = Peek();
+      if(ch == (object ? '}' : ']')) {
+        return kPathNotFound;
+      }
+      if(i > 0) {
+        if(ch != ',') {
+          return (object ? kMissCommaOrCurlyBracket : kMissCommaOrSquareBracket);
+        }
+        _cursor++;
+        ch = Peek();
+      }
+      size_t length;
+      bool found = (!object && i == index);
+      if(object) {
+        if(ch != '"') {
+          return kMissKey;
+        }
+        ReturnValue result = Measure(length);
+        if(result != kOk) {
+          return result;
+        }
+        std::string key;
+        const char *json = _data + _cursor;
+        if(_read && (_flags & kParseValidateUtf8) &&
+          ScanInvalidUtf8(json, json + length) != json + length) {
+          return kInvalidUtf8;
+        }
+        result = Value::ParseRawString(json, &key, _flags);
+        if(result != kOk) {
+          return result;
+        }
+        _cursor = json - _data;
+        if(Peek() != ':') {
+          return kMissColon;
+        }
+        _cursor++;
+        Peek();
+        found = (key == tokens[t]);
+      }
+      if(found) {
+        break;
+      }
+      ReturnValue result = Skip();
+      if(result != kOk) {
+        return result;
+      }
+    }
+  }
+  return kOk;
+}
+
+/*
+ * Skips the value at the cursor. Containers are entered rather than
+ * measured whole, so only one string or number at a time is kept in
+ * the buffer, however large the value is.
+ */
+ReturnValue ArrayReader::Skip() {
+  std::vector<char> closings;
+  while(true) {
+    char ch = Peek();
+    if(ch == '[' || ch == '{') {
+      if(_depth + closings.size() == kDefaultMaxDepth) {
+        return kDepthLimitExceeded;
+      }
+      char closing = (ch == '[' ? ']' : '}');
+      _cursor++;
+      if(Peek() == closing) {
+        _cursor++;
+      } else {
+        closings.push_back(closing);
+        if(closing == '}') {
+          ReturnValue result = SkipKey();
+          if(result != kOk) {
+            return result;
+          }
+        }
+        continue;
+      }
+    } else {
+      ReturnValue result = SkipScalar();
+      if(result != kOk) {
+        return result;
+      }
+    }
+
+    // After a value, the next one or the end of its containers
+    while(!closings.empty()) {
+      bool object = (closings.back() == '}');
+      ch = Peek();
+      if(ch == ',') {
+        _cursor++;
+        if(object) {
+          ReturnValue result = SkipKey();
+          if(result != kOk) {
+            return result;
+          }
+        }
+        break;
+      }
+      if(ch != closings.back()) {
+        return (object ? kMissCommaOrCurlyBracket : kMissCommaOrSquareBracket);
+      }
+      _cursor++;
+      closings.pop_back();
+    }
+    if(closings.empty()) {
+      return kOk;
+    }
+  }
+}
+
+// Skips a key and its colon
+ReturnValue ArrayReader::SkipKey() {
+  if(Peek() != '"') {
+    return kMissKey;
+  }
+  ReturnValue result = SkipScalar();
+  if(result != kOk) {
+    return result;
+  }
+  if(Peek() != ':') {
+    return kMissColon;
+  }
+  _cursor++;
+  return kOk;
+}
+
+/*
+ * A whole text was checked for UTF-8 by Open(),
+ * chunks are checked value by value.
+ */
+ReturnValue ArrayReader::SkipScalar() {
+  size_t length;
+  ReturnValue result = Measure(length);
+  if(result != kOk) {
+    return result;
+  }
+  const char *begin = _data + _cursor;
+  if(_read && (_flags & kParseValidateUtf8) &&
+    ScanInvalidUtf8(begin, begin + length) != begin + length) {
+    return kInvalidUtf8;
+  }
+  _cursor += length;
+  return kOk;
+}
+
+/*
+ * Finds the length of the value at the cursor, reading chunks until
+ * the validator no longer reaches the end of the buffer, or the text
+ * ends: a value cut by the end of a chunk is an error, or a number
+ * which may go on in the next chunk.
+ */
+ReturnValue ArrayReader::Measure(size_t &length) {
+  while(true) {
+    const char *json = _data + _cursor;
+    const char *end = _data + _size;
+    bool truncated;
+    ReturnValue result = ValidateValue(
+      json, end, kDefaultMaxDepth - _depth, truncated);
+    if(truncated && Fill()) {
+      continue;
+    }
+    length = json - (_data + _cursor);
+    return result;
+  }
+}
+
+ReturnValue ArrayReader::Fail(ReturnValue result) {
+  _result = result;
+  return result;
+}
+
+/**
+ * Writer
+ */
+
+Writer::Writer(std::string &text, unsigned flags)
+  : _text(text), _flags(flags) {
+}
+
+void Writer::Null() {
+  _text += "null";
+}
+
+void Writer::Boolean(bool boolean) {
+  _text += (boolean ? "true" : "false");
+}
+
+/*
+ * Writes the digits backwards from the end of the buffer,
+ * which avoids the format parsing of sprintf().
+ */
+void Writer::Int64(int64_t number) {
+  if(number >= 0) {
+    Uint64((uint64_t)number);
+    return;
+  }
+  _text.push_back('-');
+  Uint64(0 - (uint64_t)number);
+}
+
+void Writer::Uint64(uint64_t number) {
+  char buffer[24];
+  char *end = buffer + sizeof(buffer);
+  char *pointer = end;
+  do {
+    *--pointer = (char)('0' + number % 10);
+    number /= 10;
+  } while(number != 0);
+  _text.append(pointer, end - pointer);
+}
+
+void Writer::Double(double number) {
+  char buffer[32];
+  sprintf(buffer, "%.17g", number);
+  _text += buffer;
+}
+
+/*
+ * The characters which need no escape are found 16 at a time
+ * and appended as one run, whether or not non-ASCII is escaped.
+ * With kStringifyEnsureAscii every UTF-8 sequence is written as
+ * \uXXXX, or as a surrogate pair above U+FFFF, and every byte
+ * which is not part of a valid sequence as U+FFFD,
+ * so the output is always valid for kParseValidateUtf8.
+ */
+void Writer::String(const char *str, size_t length) {
+  bool ascii = (_flags & kStringifyEnsureAscii) != 0;
+  const char *pointer = str;
+  const char *end = str + length;
+  _text.push_back('\"');
+  while(true) {
+    const char *run = pointer;
+    pointer = (ascii ?
+      ScanAsciiStringChars(pointer, end) : ScanStringChars(pointer, end));
+    _text.append(run, pointer - run);
+    if(pointer == end) {
+      break;
+    }
+    unsigned char ch = *pointer++;
+    switch(ch) {
+      case '\"': _text += "\\\""; break;
+      case '\\': _text += "\\\\"; break;
+      case '\b': _text += "\\b"; break;
+      case '\f': _text += "\\f"; break;
+      case '\n': _text += "\\n"; break;
+      case '\r': _text += "\\r"; break;
+      case '\t': _text += "\\t"; break;
+      default: {
+        if(ch < 0x80) {
+          Escape(ch);
+          break;
+        }
+        const unsigned char *bytes = (const unsigned char *)pointer - 1;
+        size_t size = Utf8SequenceLength(pointer - 1, end);
+        unsigned u;
+        switch(size) {
+          case 2: u = ((ch & 0x1F) << 6) | (bytes[1] & 0x3F); break;
+          case 3: {
+            u = ((ch & 0x0F) << 12) | ((bytes[1] & 0x3F) << 6) |
+              (bytes[2] & 0x3F);
+            break;
+          }
+          case 4: {
+            u = ((ch & 0x07) << 18) | ((bytes[1] & 0x3F) << 12) |
+              ((bytes[2] & 0x3F) << 6) | (bytes[3] & 0x3F);
+            break;
+          }
+          default: u = 0xFFFD; size = 1;
+        }
+        pointer += size - 1;
+        if(u >= 0x10000) {
+          u -= 0x10000;
+          Escape(0xD800 | (u >> 10));
+          Escape(0xDC00 | (u & 0x3FF));
+        } else {
+          Escape(u);
+        }
+      }
+    }
+  }
+  _text.push_back('\"');
+}
+
+void Writer::String(const std::string &str) {
+  String(str.data(), str.length());
+}
+
+void Writer::Raw(const char *text, size_t length) {
+  _text.append(text, length);
+}
+
+void Writer::Raw(char ch) {
+  _text.push_back(ch);
+}
+
+std::string& Writer::GetText() {
+  return _text;
+}
+
+unsigned Writer::GetFlags() const {
+  return _flags;
+}
+
+// Appends \uXXXX for a UTF-16 code unit
+void Writer::Escape(unsigned u) {
+  static const char hex_digits[] = {
+    '0', '1', '2', '3',
+    '4', '5', '6', '7',
+    '8', '9', 'A', 'B',
+    'C', 'D', 'E', 'F'
+  };
+
+  char buffer[6] = {'\\', 'u',
+    hex_digits[(u >> 12) & 15], hex_digits[(u >> 8) & 15],
+    hex_digits[(u >> 4) & 15], hex_digits[u & 15]};
+  _text.append(buffer, sizeof(buffer));
+}
+}
@@ -0,0 +1,301 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerStream.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_STREAM_H
+#define TINKER_JSON_PARSER_TINKER_STREAM_H
+
+#include "TinkerConstant.h"
+#include "TinkerValue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#include <exception>
+#define TINKER_JSON_COROUTINES 1
+#endif
+
+namespace Tinker {
+/*
+ * A Reader pulls the values of a JSON text one token at a time,
+ * without building a tree, with the same grammar and error codes
+ * as Value::Parse(). Reading a value of another type than the one
+ * found returns kTypeMismatch. After an error the reader is unusable.
+ *
+ * Arrays are read with StartArray() followed by NextElement()
+ * before every element, until it reports that no element is left.
+ * Objects are read the same way with StartObject() and NextMember(),
+ * which leaves the key in GetKey() until the next member.
+ */
+class Reader {
+ public:
+  explicit Reader(const char *json);
+
+  // Scalar values
+  ReturnValue ReadNull();
+  ReturnValue ReadBoolean(bool &boolean);
+  ReturnValue ReadNumber(NumberValue &number);
+  ReturnValue ReadString(std::string &str);
+  // Any value, as a tree or skipped
+  ReturnValue ReadValue(Value &value);
+  ReturnValue SkipValue();
+
+  // Containers
+  ReturnValue StartArray();
+  ReturnValue NextElement(bool &more);
+  ReturnValue StartObject();
+  ReturnValue NextMember(bool &more);
+  const std::string& GetKey() const;
+
+  // Check that nothing but whitespace follows the root value
+  ReturnValue Finish();
+  // Position of the cursor, e.g. where an error was found
+  size_t GetOffset() const;
+
+ private:
+  ReturnValue Unexpected() const;
+  ReturnValue StartContainer(char opening);
+
+  const char *_begin;
+  const char *_end;
+  const char *_json;
+  bool _first;
+  size_t _depth;
+  std::string _key;
+  std::vector<Value::ParseFrame> _stack;
+};
+
+/*
+ * An ArrayReader parses the elements of one array one at a time,
+ * into the same Value, so the memory used does not depend on the
+ * length of the array. The array is the root of the text, or the
+ * value named by a JSON Pointer (RFC 6901) such as "/data/items".
+ * The text is either a whole NUL-terminated buffer, or read in
+ * chunks by a function which fills a buffer like fread() and returns
+ * 0 at the end of the input. Only the bytes of the current element
+ * and of one chunk are kept, the rest of the text is only validated:
+ * the values before the array are skipped one string or number at a
+ * time, so a large sibling of the array is never kept whole either.
+ *
+ * Next() frees the previous element and parses the next one,
+ * it returns false at the end of the array or on an error,
+ * which GetResult() tells apart. Missing members or elements on the
+ * path are kPathNotFound, a value which is not an array kTypeMismatch.
+ * The text after the array is not read.
+ *
+ *   ArrayReader reader(json, "/statuses");
+ *   for(Value &status : reader) { ... }
+ */
+class ArrayReader {
+ public:
+  typedef std::function<size_t(char *buffer, size_t size)> ReadFunction;
+
+  explicit ArrayReader(
+    const char *json,
+    const std::string &pointer = "",
+    unsigned flags = kParseDefault);
+  explicit ArrayReader(
+    const ReadFunction &read,
+    const std::string &pointer = "",
+    unsigned flags = kParseDefault);
+
+  bool Next(Value &value);
+  ReturnValue GetResult() const;
+  // Offset of the cursor in the whole text
+  size_t GetOffset() const;
+
+  /*
+   * A single-pass input iterator over the elements,
+   * which live in the reader until the next step.
+   */
+  class Iterator {
+   public:
+    Iterator() : _reader(nullptr) {
+    }
+    explicit Iterator(ArrayReader *reader) : _reader(reader) {
+      ++*this;
+    }
+
+    Value& operator*() const {
+      return _reader->_element;
+    }
+    Value* operator->() const {
+      return &(_reader->_element);
+    }
+    Iterator& operator++() {
+      if(!_reader->Next(_reader->_element)) {
+        _reader = nullptr;
+      }
+      return *this;
+    }
+    bool operator==(const Iterator &other) const {
+      return _reader == other._reader;
+    }
+    bool operator!=(const Iterator &other) const {
+      return _reader != other._reader;
+    }
+
+   private:
+    ArrayReader *_reader;
+  };
+
+  Iterator begin();
+  Iterator end();
+
+ private:
+  char Peek();
+  bool Fill();
+  ReturnValue Open();
+  ReturnValue Skip();
+  ReturnValue SkipKey();
+  ReturnValue SkipScalar();
+  ReturnValue Measure(size_t &length);
+  ReturnValue Fail(ReturnValue result);
+
+  ReadFunction _read;
+  std::string _buffer;
+  const char *_data;
+  size_t _size;
+  size_t _cursor;
+  size_t _consumed;
+  bool _eof;
+
+  std::string _pointer;
+  unsigned _flags;
+  size_t _depth;
+  bool _opened;
+  bool _first;
+  bool _done;
+  ReturnValue _result;
+  Value _element;
+  std::vector<Value::ParseFrame> _stack;
+};
+
+#ifdef TINKER_JSON_COROUTINES
+/*
+ * A generator for C++20 coroutines, the values yielded
+ * live in the coroutine until it is resumed.
+ */
+template<typename T>
+class Generator {
+ public:
+  struct promise_type {
+    T *current;
+
+    Generator get_return_object() {
+      return Generator(
+        std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept {
+      return std::suspend_always();
+    }
+    std::suspend_always final_suspend() noexcept {
+      return std::suspend_always();
+    }
+    std::suspend_always yield_value(T &value) noexcept {
+      current = &value;
+      return std::suspend_always();
+    }
+    void return_void() noexcept {
+    }
+    void unhandled_exception() {
+      std::terminate();
+    }
+  };
+
+  class Iterator {
+   public:
+    explicit Iterator(std::coroutine_handle<promise_type> handle)
+      : _handle(handle) {
+    }
+
+    T& operator*() const {
+      return *(_handle.promise().current);
+    }
+    Iterator& operator++() {
+      _handle.resume();
+      return *this;
+    }
+    bool operator==(std::default_sentinel_t) const {
+      return !_handle || _handle.done();
+    }
+
+   private:
+    std::coroutine_handle<promise_type> _handle;
+  };
+
+  explicit Generator(std::coroutine_handle<promise_type> handle)
+    : _handle(handle) {
+  }
+  Generator(Generator &&other) noexcept : _handle(other._handle) {
+    other._handle = nullptr;
+  }
+  Generator(const Generator &) = delete;
+  Generator& operator=(const Generator &) = delete;
+  ~Generator() {
+    if(_handle) {
+      _handle.destroy();
+    }
+  }
+
+  Iterator begin() {
+    _handle.resume();
+    return Iterator(_handle);
+  }
+  std::default_sentinel_t end() {
+    return std::default_sentinel;
+  }
+
+ private:
+  std::coroutine_handle<promise_type> _handle;
+};
+
+// Yields the elements of the reader, each one freed before the next
+inline Generator<Value> Elements(ArrayReader &reader) {
+  Value element;
+  while(reader.Next(element)) {
+    co_yield element;
+  }
+}
+#endif
+
+/*
+ * A Writer appends JSON tokens to a string, with the same output
+ * as Value::Stringify(). Raw() appends text which is already JSON,
+ * e.g. precomputed member keys, separators and brackets.
+ * The flags are combinations of StringifyFlag.
+ */
+class Writer {
+ public:
+  explicit Writer(std::string &text, unsigned flags = kStringifyDefault);
+
+  void Null();
+  void Boolean(bool boolean);
+  void Int64(int64_t number);
+  void Uint64(uint64_t number);
+  void Double(double number);
+  void String(const char *str, size_t length);
+  void String(const std::string &str);
+  void Raw(const char *text, size_t length);
+  void Raw(char ch);
+
+  std::string& GetText();
+  unsigned GetFlags() const;
+
+ private:
+  void Escape(unsigned u);
+
+  std::string &_text;
+  unsigned _flags;
+};
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_STREAM_H
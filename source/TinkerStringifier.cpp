@@ -6,10 +6,12 @@
  */
 
 #include "source/TinkerConstant.h"
+#include "source/TinkerStream.h"
 #include "source/TinkerValue.h"
 
 #include <cerrno>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <string>
@@ -27,7 +29,8 @@ namespace Tinker {
  * Any other stringifier functions are private
  * and invisible to the outside.
  */
-ReturnValue Value::Stringify(std::string &text) const {
+ReturnValue Value::Stringify(std::string &text, unsigned flags) const {
+  flags &= ~kStringifyCached;
   switch(_type) {
     case kNull: {
       return StringifyLiteral("null", text);
@@ -42,13 +45,13 @@ ReturnValue Value::Stringify(std::string &text) const {
       return StringifyNumber(text);
     }
     case kString: {
-      return StringifyString(text);
+      return StringifyString(text, flags);
     }
     case kArray: {
-      return StringifyArray(text);
+      return StringifyArray(text, flags);
     }
     case kObject: {
-      return StringifyObject(text);
+      return StringifyObject(text, flags);
     }
     default: {
       return kInvalidValue;
@@ -56,6 +59,14 @@ ReturnValue Value::Stringify(std::string &text) const {
   }
 }
 
+// Only a value which may be changed keeps its text
+ReturnValue Value::Stringify(std::string &text, unsigned flags) {
+  if(flags & kStringifyCached) {
+    return StringifyCached(text, flags & ~kStringifyCached);
+  }
+  return static_cast<const Value &>(*this).Stringify(text, flags);
+}
+
 /**
  * The functions below are private.
  */
@@ -68,52 +79,29 @@ ReturnValue Value::StringifyLiteral(
 }
 
 ReturnValue Value::StringifyNumber(std::string &text) const {
-  char buffer[32];
-  sprintf(buffer, "%.17g", _value._number);
-  text += buffer;
+  if(_flags & kFlagRawNumber) {
+    text += (_value._raw)->text;
+  } else if(_flags & kFlagInt64) {
+    Writer(text).Int64(_value._int64);
+  } else if(_flags & kFlagUint64) {
+    Writer(text).Uint64(_value._uint64);
+  } else {
+    Writer(text).Double(_value._number);
+  }
   return kOk;
 }
 
-ReturnValue Value::StringifyString(std::string &text) const {
-  static const char hex_digits[] = {
-    '0', '1', '2', '3',
-    '4', '5', '6', '7',
-    '8', '9', 'A', 'B',
-    'C', 'D', 'E', 'F'
-  };
-
-  text.push_back('\"');
-  size_t length = (_value._string)->length();
-  for(size_t i = 0; i < length; ++i) {
-    char ch = (_value._string)->at(i);
-    switch(ch) {
-      case '\"': text += "\\\""; break;
-      case '\\': text += "\\\\"; break;
-      case '\b': text += "\\b"; break;
-      case '\f': text += "\\f"; break;
-      case '\n': text += "\\n"; break;
-      case '\r': text += "\\r"; break;
-      case '\t': text += "\\t"; break;
-      default: {
-        if(ch < 0x20) {
-          text += "\\u00";
-          text.push_back(hex_digits[ch >> 4]);
-          text.push_back(hex_digits[ch & 15]);
-        } else {
-          text.push_back(ch);
-        }
-      }
-    }
-  }
-  text.push_back('\"');
+ReturnValue Value::StringifyString(std::string &text, unsigned flags) const {
+  Writer(text, flags).String(*(_value._string));
   return kOk;
 }
 
-ReturnValue Value::StringifyArray(std::string &text) const {
+ReturnValue Value::StringifyArray(std::string &text, unsigned flags) const {
   text.push_back('[');
   size_t size = (_value._array)->size();
   for(size_t i = 0; i < size; ++i) {
-    (_value._array)->at(i)->Stringify(text);
+    const Value &element = *((_value._array)->at(i));
+    element.Stringify(text, flags);
     text += ",";
   }
   if(text.back() == ',') {
@@ -123,16 +111,17 @@ ReturnValue Value::StringifyArray(std::string &text) const {
   return kOk;
 }
 
-ReturnValue Value::StringifyObject(std::string &text) const {
+// Keys are escaped like string values
+ReturnValue Value::StringifyObject(std::string &text, unsigned flags) const {
+  Writer writer(text, flags);
   text.push_back('{');
   for(auto it = (_value._object)->begin();
     it != (_value._object)->end();
     ++it) {
-    text.push_back('"');
-    text += it->first;
-    text.push_back('"');
+    writer.String(it->first);
     text.push_back(':');
-    it->second->Stringify(text);
+    const Value &member = *(it->second);
+    member.Stringify(text, flags);
     text.push_back(',');
   }
   if(text.back() == ',') {
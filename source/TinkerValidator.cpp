@@ -0,0 +1,422 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerValidator.cpp
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#include "source/TinkerConstant.h"
+#include "source/TinkerSimd.h"
+#include "source/TinkerValidator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+namespace Tinker {
+/**
+ * Tool functions
+ */
+
+/*
+ * 2^1024 - 2^970, the smallest decimal which strtod() rounds to
+ * infinity: every number from it on is kNumberTooBig for the parser.
+ */
+static const char kOverflowDigits[] =
+  "17976931348623158079372897140530341507993413271003782693617377898044"
+  "49682927647509466490179775872070963302864166928879109465555478519404"
+  "02630657488671505820681908902000708383676273854845817711531764475730"
+  "27006985557136695962284291481986083493647529271907416844436551070434"
+  "2711559699508093042880177904174497792";
+static const long long kOverflowExponent = 309;
+
+/*
+ * The state of one validation, the cursor never passes end.
+ * Open containers are kept as one bit each, set for objects,
+ * so the depth limit bounds the stack of the validator.
+ */
+class Validator {
+ public:
+  Validator(const char *json, const char *end, unsigned flags)
+    : _pointer(json), _end(end), _flags(flags), _truncated(false) {
+  }
+
+  ReturnValue ValidateValue(size_t max_depth);
+  void SkipWhitespace();
+
+  const char *_pointer;
+  const char *_end;
+  unsigned _flags;
+  // Whether end was reached, past which more text could change the result
+  mutable bool _truncated;
+
+ private:
+  char Peek(const char *pointer) const {
+    if(pointer < _end) {
+      return *pointer;
+    }
+    _truncated = true;
+    return '\0';
+  }
+  ReturnValue ValidateLiteral(const char *literal);
+  ReturnValue ValidateNumber();
+  ReturnValue ValidateString();
+  ReturnValue ValidateKey();
+  const char* ValidateHex4(const char *pointer, unsigned *u) const;
+  bool IsTooBig(
+    const char *integer,
+    const char *integer_end,
+    const char *fraction,
+    const char *fraction_end,
+    long long exponent) const;
+};
+
+void Validator::SkipWhitespace() {
+  if(_pointer < _end && (unsigned char)*_pointer <= ' ') {
+    _pointer = ScanWhitespace(_pointer, _end);
+  }
+}
+
+ReturnValue Validator::ValidateValue(size_t max_depth) {
+  uint64_t objects[kDefaultMaxDepth / 64];
+  size_t depth = 0;
+  if(max_depth > kDefaultMaxDepth) {
+    max_depth = kDefaultMaxDepth;
+  }
+  while(true) {
+    ReturnValue result = kOk;
+    bool complete = true;
+    switch(Peek(_pointer)) {
+      case 'n': result = ValidateLiteral("null"); break;
+      case 't': result = ValidateLiteral("true"); break;
+      case 'f': result = ValidateLiteral("false"); break;
+      case '"': result = ValidateString(); break;
+      case '[':
+      case '{': {
+        if(depth == max_depth) {
+          return kDepthLimitExceeded;
+        }
+        bool object = (*_pointer == '{');
+        _pointer++;
+        SkipWhitespace();
+        if(Peek(_pointer) == (object ? '}' : ']')) {
+          _pointer++;
+          break;
+        }
+        if(object) {
+          objects[depth / 64] |= (uint64_t)1 << (depth % 64);
+          result = ValidateKey();
+        } else {
+          objects[depth / 64] &= ~((uint64_t)1 << (depth % 64));
+        }
+        depth++;
+        complete = false;
+        break;
+      }
+      case '\0': return kExpectValue;
+      default: result = ValidateNumber();
+    }
+    if(result != kOk) {
+      return result;
+    }
+    if(!complete) {
+      continue;
+    }
+
+    // Close the containers the value completes
+    while(depth > 0) {
+      bool object = (objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+      SkipWhitespace();
+      char ch = Peek(_pointer);
+      if(ch == ',') {
+        _pointer++;
+        SkipWhitespace();
+        if(object) {
+          result = ValidateKey();
+          if(result != kOk) {
+            return result;
+          }
+        }
+        break;
+      } else if(ch == (object ? '}' : ']')) {
+        _pointer++;
+        depth--;
+      } else {
+        return (object ? kMissCommaOrCurlyBracket : kMissCommaOrSquareBracket);
+      }
+    }
+    if(depth == 0) {
+      return kOk;
+    }
+  }
+}
+
+ReturnValue Validator::ValidateLiteral(const char *literal) {
+  const char *pointer = _pointer + 1;
+  for(size_t i = 1; literal[i]; ++i, ++pointer) {
+    if(Peek(pointer) != literal[i]) {
+      return kInvalidValue;
+    }
+  }
+  _pointer = pointer;
+  return kOk;
+}
+
+/*
+ * The same grammar as the parser. strtod() is never called:
+ * a number is too big when it is at least kOverflowDigits.
+ */
+ReturnValue Validator::ValidateNumber() {
+  const char *pointer = _pointer;
+  if(Peek(pointer) == '-') {
+    pointer++;
+  }
+  const char *integer = pointer;
+  if(Peek(pointer) == '0') {
+    pointer++;
+  } else {
+    char ch = Peek(pointer);
+    if(ch < '1' || ch > '9') return kInvalidValue;
+    do pointer++; while(Peek(pointer) >= '0' && Peek(pointer) <= '9');
+  }
+  const char *integer_end = pointer;
+  const char *fraction = pointer;
+  const char *fraction_end = pointer;
+  if(Peek(pointer) == '.') {
+    pointer++;
+    fraction = pointer;
+    char ch = Peek(pointer);
+    if(ch < '0' || ch > '9') return kInvalidValue;
+    do pointer++; while(Peek(pointer) >= '0' && Peek(pointer) <= '9');
+    fraction_end = pointer;
+  }
+  long long exponent = 0;
+  if(Peek(pointer) == 'e' || Peek(pointer) == 'E') {
+    pointer++;
+    bool negative = false;
+    if(Peek(pointer) == '+' || Peek(pointer) == '-') {
+      negative = (*pointer == '-');
+      pointer++;
+    }
+    char ch = Peek(pointer);
+    if(ch < '0' || ch > '9') return kInvalidValue;
+    do {
+      if(exponent < 100000) exponent = exponent * 10 + (*pointer - '0');
+      pointer++;
+    } while(Peek(pointer) >= '0' && Peek(pointer) <= '9');
+    if(negative) {
+      exponent = -exponent;
+    }
+  }
+  if(IsTooBig(integer, integer_end, fraction, fraction_end, exponent)) {
+    return kNumberTooBig;
+  }
+  _pointer = pointer;
+  return kOk;
+}
+
+/*
+ * The significant digits d1 d2 ... make the number 0.d1d2... * 10^p.
+ * Below 10^308 it fits, from 10^309 on it does not,
+ * in between the digits are compared with kOverflowDigits.
+ */
+bool Validator::IsTooBig(
+  const char *integer,
+  const char *integer_end,
+  const char *fraction,
+  const char *fraction_end,
+  long long exponent) const {
+  const char *digits = integer;
+  long long power = integer_end - integer;
+  if(*integer == '0') {
+    digits = fraction;
+    while(digits < fraction_end && *digits == '0') {
+      digits++;
+    }
+    if(digits == fraction_end) {
+      return false;
+    }
+    power = fraction - digits;
+  }
+  power += exponent;
+  if(power != kOverflowExponent) {
+    return power > kOverflowExponent;
+  }
+
+  const char *limit = kOverflowDigits;
+  while(*limit != '\0') {
+    if(digits == integer_end) {
+      digits = fraction;
+    }
+    if(digits == fraction_end) {
+      return false;
+    }
+    if(*digits != *limit) {
+      return *digits > *limit;
+    }
+    digits++;
+    limit++;
+  }
+  return true;
+}
+
+const char* Validator::ValidateHex4(const char *pointer, unsigned *u) const {
+  *u = 0;
+  for(int i = 0; i < 4; ++i) {
+    char ch = Peek(pointer++);
+    *u <<= 4;
+    if(ch >= '0' && ch <= '9') *u |= ch - '0';
+    else if(ch >= 'A' && ch <= 'F') *u |= ch - ('A' - 10);
+    else if(ch >= 'a' && ch <= 'f') *u |= ch - ('a' - 10);
+    else return nullptr;
+  }
+  return pointer;
+}
+
+/*
+ * Plain characters are skipped 16 at a time,
+ * the checks only run on escapes and on invalid characters.
+ * On an error the cursor is left on the character or escape at fault.
+ */
+ReturnValue Validator::ValidateString() {
+  const char *pointer = _pointer + 1;
+  while(true) {
+    pointer = ScanStringChars(pointer, _end);
+    _pointer = pointer;
+    char ch = Peek(pointer++);
+    switch(ch) {
+      case '"': {
+        _pointer = pointer;
+        return kOk;
+      }
+      case '\0': {
+        return kMissQuotationMark;
+      }
+      case '\\': {
+        switch(Peek(pointer++)) {
+          case '"':
+          case '\\':
+          case '/':
+          case 'b':
+          case 'f':
+          case 'n':
+          case 'r':
+          case 't': break;
+          case 'u': {
+            unsigned u1, u2;
+            pointer = ValidateHex4(pointer, &u1);
+            if(pointer == nullptr)
+              return kInvalidUnicodeHex;
+            if(u1 >= 0xD800 && u1 <= 0xDBFF) {
+              if(Peek(pointer++) != '\\')
+                return kInvalidUnicodeSurrogate;
+              if(Peek(pointer++) != 'u')
+                return kInvalidUnicodeSurrogate;
+              pointer = ValidateHex4(pointer, &u2);
+              if(pointer == nullptr)
+                return kInvalidUnicodeHex;
+              if(u2 < 0xDC00 || u2 > 0xDFFF)
+                return kInvalidUnicodeSurrogate;
+            } else if(u1 >= 0xDC00 && u1 <= 0xDFFF &&
+              (_flags & kParseValidateUtf8)) {
+              return kInvalidUnicodeSurrogate;
+            }
+            break;
+          }
+          default: {
+            return kInvalidStringEscape;
+          }
+        }
+        break;
+      }
+      default: {
+        return kInvalidStringChar;
+      }
+    }
+  }
+}
+
+ReturnValue Validator::ValidateKey() {
+  if(Peek(_pointer) != '"') {
+    return kMissKey;
+  }
+  ReturnValue result = ValidateString();
+  if(result != kOk) {
+    return result;
+  }
+  SkipWhitespace();
+  if(Peek(_pointer) != ':') {
+    return kMissColon;
+  }
+  _pointer++;
+  SkipWhitespace();
+  return kOk;
+}
+
+/**
+ * Validation functions
+ */
+
+ReturnValue Validate(const char *json, size_t length, unsigned flags) {
+  size_t offset;
+  return Validate(json, length, offset, flags);
+}
+
+/*
+ * A NUL byte right at the end of the range is accepted,
+ * so the length may include the terminator.
+ * As for the parser, the encoding is checked up to the first NUL
+ * before the grammar.
+ */
+ReturnValue Validate(
+  const char *json,
+  size_t length,
+  size_t &offset,
+  unsigned flags) {
+  if(flags & kParseValidateUtf8) {
+    const char *end = (const char *)memchr(json, '\0', length);
+    if(end == nullptr) {
+      end = json + length;
+    }
+    const char *invalid = ScanInvalidUtf8(json, end);
+    if(invalid != end) {
+      offset = invalid - json;
+      return kInvalidUtf8;
+    }
+  }
+  Validator validator(json, json + length, flags);
+  validator.SkipWhitespace();
+  ReturnValue result = validator.ValidateValue(kDefaultMaxDepth);
+  if(result == kOk) {
+    validator.SkipWhitespace();
+    const char *pointer = validator._pointer;
+    if(pointer != validator._end &&
+      !(*pointer == '\0' && pointer + 1 == validator._end)) {
+      result = kNotSingular;
+    }
+  }
+  offset = validator._pointer - json;
+  return result;
+}
+
+ReturnValue ValidateValue(
+  const char *&json,
+  const char *end,
+  size_t max_depth) {
+  bool truncated;
+  return ValidateValue(json, end, max_depth, truncated);
+}
+
+ReturnValue ValidateValue(
+  const char *&json,
+  const char *end,
+  size_t max_depth,
+  bool &truncated) {
+  Validator validator(json, end, kParseDefault);
+  ReturnValue result = validator.ValidateValue(max_depth);
+  json = validator._pointer;
+  truncated = validator._truncated;
+  return result;
+}
+}
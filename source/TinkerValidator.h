@@ -0,0 +1,55 @@
+/*
+ * Project: Tinker_Json_Parser
+ * File: TinkerValidator.h
+ * Author: agent
+ * Date: 2026/10/19
+ */
+
+#ifndef TINKER_JSON_PARSER_TINKER_VALIDATOR_H
+#define TINKER_JSON_PARSER_TINKER_VALIDATOR_H
+
+#include "TinkerConstant.h"
+
+#include <cstddef>
+
+namespace Tinker {
+/*
+ * Checks that a text is a single JSON value without building it,
+ * and without allocating. The grammar, the depth limit and the
+ * error codes are those of Value::Parse(), numbers included.
+ * A NUL byte ends the text as it does for Value::Parse(),
+ * any byte after it in the range makes the text not singular.
+ * The offset is where the error was found, or the length.
+ * Of the parse flags only kParseValidateUtf8 changes the result.
+ */
+ReturnValue Validate(
+  const char *json,
+  size_t length,
+  unsigned flags = kParseDefault);
+ReturnValue Validate(
+  const char *json,
+  size_t length,
+  size_t &offset,
+  unsigned flags = kParseDefault);
+
+/*
+ * Validates the value at the cursor and moves the cursor past it,
+ * or to where the error was found.
+ */
+ReturnValue ValidateValue(
+  const char *&json,
+  const char *end,
+  size_t max_depth = kDefaultMaxDepth);
+
+/*
+ * The same, and tells whether the validator looked at end: only then
+ * could the result change if the text went on, e.g. "tr" or "12".
+ */
+ReturnValue ValidateValue(
+  const char *&json,
+  const char *end,
+  size_t max_depth,
+  bool &truncated);
+}
+
+#endif //TINKER_JSON_PARSER_TINKER_VALIDATOR_H
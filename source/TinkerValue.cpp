@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 
@@ -22,15 +23,24 @@ namespace Tinker {
  * Constructors & Destructors
  */
 
+RawNumber::RawNumber() {
+  converted = false;
+}
+
+void RawNumber::clear() {
+  text.clear();
+  converted = false;
+}
+
 Value::Value() {
   _type = kNull;
-  _json = nullptr;
+  _flags = 0;
   _value._string = nullptr;
 }
 
 Value::Value(const char *json) {
   _type = kNull;
-  _json = nullptr;
+  _flags = 0;
   _value._string = nullptr;
   Parse(json);
 }
@@ -39,30 +49,142 @@ Value::~Value() {
   Free();
 }
 
+/**
+ * Public functions
+ */
+
+/*
+ * The nodes keep their places in the trees, so both changed there.
+ * A cache held by a root container moves with the container.
+ */
+void Value::Swap(Value &other) {
+  MarkDirty();
+  other.MarkDirty();
+  std::swap(_type, other._type);
+  std::swap(_flags, other._flags);
+  std::swap(_value, other._value);
+}
+
 /**
  * Private functions
  */
 
+/*
+ * A borrowed payload is owned by the ParserContext which handed it out,
+ * it is only forgotten here and reused by the context later.
+ * Containers are torn down without recursion, see ReleaseChildren().
+ */
 void Value::Free() {
-  if(_type == kString) {
+  if(_flags & kFlagBorrowed) {
+    _value._string = nullptr;
+  } else if(_flags & kFlagRawNumber) {
+    delete _value._raw;
+    _value._raw = nullptr;
+  } else if(_type == kString) {
     delete _value._string;
     _value._string = nullptr;
-  } else if(_type == kArray) {
+  } else if(_type == kArray || _type == kObject) {
+    std::vector<Value *> pending;
+    ReleaseChildren(pending);
+    while(!pending.empty()) {
+      Value *value = pending.back();
+      pending.pop_back();
+      value->ReleaseChildren(pending);
+      delete value;
+    }
+  }
+  _flags &= ~(kPayloadFlags | kFlagCached | kFlagHashed);
+  _type = kNull;
+}
+
+/*
+ * Deletes the storage of a container and the leaves in it.
+ * Nested containers are added to pending instead of being deleted,
+ * so the depth of the tree never reaches the call stack,
+ * and the worklist only grows with the nested containers.
+ * Shared nodes are left to the frozen tree which owns them.
+ * The container is left as null.
+ */
+void Value::ReleaseChildren(std::vector<Value *> &pending) {
+  if(_type == kArray) {
     size_t array_size = (_value._array)->size();
     for(size_t i = 0; i < array_size; ++i) {
-      delete (_value._array)->at(i);
+      Value *child = (_value._array)->at(i);
+      if(child->_flags & kFlagShared) {
+        continue;
+      } else if(child->_type == kArray || child->_type == kObject) {
+        pending.push_back(child);
+      } else {
+        delete child;
+      }
+    }
+    if(_flags & kFlagCacheRoot) {
+      DeleteCacheRoot();
+    } else {
+      delete _value._array;
     }
-    delete _value._array;
-    _value._array = nullptr;
   } else if(_type == kObject) {
     for(auto it = (_value._object)->begin();
       it != (_value._object)->end();
       ++it) {
-      delete it->second;
+      Value *child = it->second;
+      if(child->_flags & kFlagShared) {
+        continue;
+      } else if(child->_type == kArray || child->_type == kObject) {
+        pending.push_back(child);
+      } else {
+        delete child;
+      }
+    }
+    if(_flags & kFlagCacheRoot) {
+      DeleteCacheRoot();
+    } else {
+      delete _value._object;
     }
-    delete _value._object;
-    _value._object = nullptr;
   }
+  _value._string = nullptr;
+  _flags &= ~(kPayloadFlags | kFlagCached | kFlagHashed);
   _type = kNull;
 }
-}
\ No newline at end of file
+
+/*
+ * Converts the text of a raw number on first access,
+ * with the same rules as the parser, and caches the result.
+ * This writes to the tree, so a document read by several threads
+ * has its raw numbers converted before it is shared.
+ */
+const NumberValue& Value::ConvertRawNumber() const {
+  RawNumber &raw = *(_value._raw);
+  if(!raw.converted) {
+    Value number;
+    number.Parse(raw.text.c_str());
+    raw.number = number.ReadNumber();
+    raw.converted = true;
+  }
+  return raw.number;
+}
+
+/*
+ * Converts every raw number of the tree.
+ * The walk uses an explicit stack, like Free().
+ */
+void Value::ConvertRawNumbers() const {
+  std::vector<const Value *> stack(1, this);
+  while(!stack.empty()) {
+    const Value *value = stack.back();
+    stack.pop_back();
+    if(value->_type == kNumber && (value->_flags & kFlagRawNumber)) {
+      value->ConvertRawNumber();
+    } else if(value->_type == kArray) {
+      stack.insert(stack.end(),
+        (value->_value._array)->begin(), (value->_value._array)->end());
+    } else if(value->_type == kObject) {
+      for(auto it = (value->_value._object)->begin();
+        it != (value->_value._object)->end();
+        ++it) {
+        stack.push_back(it->second);
+      }
+    }
+  }
+}
+}
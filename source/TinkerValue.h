@@ -9,19 +9,238 @@
 #define TINKER_JSON_PARSER_TINKER_VALUE_H
 
 #include "TinkerConstant.h"
+#include "TinkerMemory.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <iterator>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace Tinker {
+class ArrayReader;
+class ParserContext;
+class NodeCache;
+class Patcher;
+class Reader;
+class SharedDocument;
+
+/*
+ * A number as it is stored, exactly for integers.
+ */
+struct NumberValue {
+  enum Kind {
+    kDouble,
+    kInt64,
+    kUint64
+  };
+
+  Kind kind;
+  union {
+    double number;
+    int64_t int64;
+    uint64_t uint64;
+  } value;
+};
+
+/*
+ * The source text of a number parsed with kParseRawNumbers,
+ * and its value once it has been converted.
+ */
+struct RawNumber {
+  RawNumber();
+  void clear();
+
+  std::string text;
+  bool converted;
+  NumberValue number;
+};
+
+/*
+ * A member key prepared once for lookups in many objects, e.g. the
+ * same field of every element of an array. It is hashed once when it
+ * is made, and every object finds its bucket from that hash, whatever
+ * its size; only a missing key is hashed again, to confirm the miss.
+ * A Key does not change on lookups, so threads can share it.
+ */
+class Key {
+ public:
+  explicit Key(const char *key);
+  explicit Key(const std::string &key);
+
+  const std::string& GetText() const;
+
+ private:
+  friend class Value;
+
+  std::string _text;
+  size_t _hash;
+};
+
 class Value {
  public:
+  /*
+   * Iterators over the elements of an array and the members of an
+   * object, in the order of the underlying containers. The type is
+   * checked once by GetElements() or GetMembers(), not at every step.
+   * Changing the container invalidates them as it does its iterators.
+   * The iterators of a const value only give const references.
+   * Both work with the algorithms of <algorithm> and <iterator>.
+   */
+  template<typename ValueType>
+  class BasicElementIterator {
+   public:
+    typedef std::vector<Value *>::const_iterator Base;
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ValueType value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef ValueType* pointer;
+    typedef ValueType& reference;
+
+    BasicElementIterator() : _it() {
+    }
+    explicit BasicElementIterator(Base it) : _it(it) {
+    }
+
+    ValueType& operator*() const {
+      return **_it;
+    }
+    ValueType* operator->() const {
+      return *_it;
+    }
+    BasicElementIterator& operator++() {
+      ++_it;
+      return *this;
+    }
+    BasicElementIterator operator++(int) {
+      BasicElementIterator old = *this;
+      ++_it;
+      return old;
+    }
+    bool operator==(const BasicElementIterator &other) const {
+      return _it == other._it;
+    }
+    bool operator!=(const BasicElementIterator &other) const {
+      return _it != other._it;
+    }
+
+   private:
+    Base _it;
+  };
+  typedef BasicElementIterator<Value> ElementIterator;
+  typedef BasicElementIterator<const Value> ConstElementIterator;
+
+  // A member of an object, as seen through a MemberIterator
+  template<typename ValueType>
+  struct BasicMember {
+    const std::string &key;
+    ValueType &value;
+  };
+  typedef BasicMember<Value> Member;
+  typedef BasicMember<const Value> ConstMember;
+
+  /*
+   * A member is made on each dereference, so it is given by value and
+   * the iterator is an input iterator: algorithms which keep references
+   * to what they read, like std::max_element, need the keys instead.
+   */
+  template<typename ValueType>
+  class BasicMemberIterator {
+   public:
+    typedef std::unordered_map<std::string, Value *>::const_iterator Base;
+
+    // What operator-> returns, holding the member it points to
+    class Pointer {
+     public:
+      explicit Pointer(const BasicMember<ValueType> &member)
+        : _member(member) {
+      }
+      const BasicMember<ValueType>* operator->() const {
+        return &_member;
+      }
+
+     private:
+      BasicMember<ValueType> _member;
+    };
+
+    typedef std::input_iterator_tag iterator_category;
+    typedef BasicMember<ValueType> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Pointer pointer;
+    typedef BasicMember<ValueType> reference;
+
+    BasicMemberIterator() : _it() {
+    }
+    explicit BasicMemberIterator(Base it) : _it(it) {
+    }
+
+    BasicMember<ValueType> operator*() const {
+      BasicMember<ValueType> member = {_it->first, *(_it->second)};
+      return member;
+    }
+    Pointer operator->() const {
+      return Pointer(**this);
+    }
+    BasicMemberIterator& operator++() {
+      ++_it;
+      return *this;
+    }
+    BasicMemberIterator operator++(int) {
+      BasicMemberIterator old = *this;
+      ++_it;
+      return old;
+    }
+    bool operator==(const BasicMemberIterator &other) const {
+      return _it == other._it;
+    }
+    bool operator!=(const BasicMemberIterator &other) const {
+      return _it != other._it;
+    }
+
+   private:
+    Base _it;
+  };
+  typedef BasicMemberIterator<Value> MemberIterator;
+  typedef BasicMemberIterator<const Value> ConstMemberIterator;
+
+  // A pair of iterators for range-based for loops
+  template<typename Iterator>
+  class Range {
+   public:
+    Range(Iterator first, Iterator last) : _begin(first), _end(last) {
+    }
+
+    Iterator begin() const {
+      return _begin;
+    }
+    Iterator end() const {
+      return _end;
+    }
+
+   private:
+    Iterator _begin;
+    Iterator _end;
+  };
+
   Value();
   Value(const char *json);
   ~Value();
 
+  // Exchange the trees of two values without copying
+  void Swap(Value &other);
+
+  // Nodes are allocated through the installed Allocator, if any
+  static void* operator new(size_t size);
+  static void operator delete(void *pointer, size_t size);
+
+  // Memory usage of the tree
+  MemoryStats GetMemoryStats() const;
+  // Leave the value null and free its tree on a background thread
+  void FreeInBackground();
+
   // Type wrapper
   Type GetType() const;
   const char* GetTypeString() const;
@@ -31,65 +250,265 @@ class Value {
   // Numeric member wrapper
   double GetNumber() const;
   void SetNumber(double number);
+  // Exact integer member wrapper
+  bool IsInt64() const;
+  bool IsUint64() const;
+  int64_t GetInt64() const;
+  uint64_t GetUint64() const;
+  void SetInt64(int64_t number);
+  void SetUint64(uint64_t number);
+  /*
+   * The getters of a const value return const references, so a const
+   * tree, such as a snapshot of a SharedDocument, cannot be changed
+   * through them. The others return references to change it in place.
+   */
   // String member wrapper
-  std::string& GetString() const;
+  std::string& GetString();
+  const std::string& GetString() const;
   size_t GetLength() const;
   void SetString(std::string &str);
   void SetString(const char *str, size_t length);
   // Array member wrapper
-  Value& GetElement(size_t index) const;
+  Value& GetElement(size_t index);
+  const Value& GetElement(size_t index) const;
   size_t GetArraySize() const;
   void SetArray(std::vector<Value *> &vec);
+  Range<ElementIterator> GetElements();
+  Range<ConstElementIterator> GetElements() const;
   // Object member wrapper
-  Value& GetValue(const std::string &key) const;
+  Value& GetValue(const std::string &key);
+  Value& GetValue(const char *key);
+  Value& GetValue(const char *key, size_t length);
+  Value& GetValue(const Key &key);
+  const Value& GetValue(const std::string &key) const;
+  const Value& GetValue(const char *key) const;
+  const Value& GetValue(const char *key, size_t length) const;
+  const Value& GetValue(const Key &key) const;
   bool HasKey(const std::string &key) const;
+  bool HasKey(const char *key) const;
+  bool HasKey(const Key &key) const;
+  // One lookup, nullptr when the key is missing or this is not an object
+  Value* Find(const std::string &key);
+  Value* Find(const char *key);
+  Value* Find(const char *key, size_t length);
+  Value* Find(const Key &key);
+  const Value* Find(const std::string &key) const;
+  const Value* Find(const char *key) const;
+  const Value* Find(const char *key, size_t length) const;
+  const Value* Find(const Key &key) const;
   size_t GetObjectSize() const;
   void SetObject(std::unordered_map<std::string, Value *> &obj);
+  Range<MemberIterator> GetMembers();
+  Range<ConstMemberIterator> GetMembers() const;
   // Operator overloading
-  Value& operator[] (size_t index) const;
-  Value& operator[] (const std::string &key) const;
+  Value& operator[] (size_t index);
+  Value& operator[] (const std::string &key);
+  Value& operator[] (const Key &key);
+  const Value& operator[] (size_t index) const;
+  const Value& operator[] (const std::string &key) const;
+  const Value& operator[] (const Key &key) const;
+  // String literals, looked up without building a std::string
+  template<size_t N>
+  Value& operator[] (const char (&key)[N]) {
+    return GetValue(key, std::char_traits<char>::length(key));
+  }
+  template<size_t N>
+  const Value& operator[] (const char (&key)[N]) const {
+    return GetValue(key, std::char_traits<char>::length(key));
+  }
+  // Deep comparison, numbers by value and members in any order
+  bool operator==(const Value &other) const;
+  bool operator!=(const Value &other) const;
 
-  // Parse json texts
-  ReturnValue Parse(const char *json);
+  /*
+   * A 64-bit hash of the structure, equal values have equal hashes.
+   * The hash of a container is kept with the hashes of its nodes by
+   * the container, as kStringifyCached keeps text, and only the nodes
+   * changed since the last call are hashed again. The changes are
+   * marked in the nodes, so one value of a tree, normally its root,
+   * keeps text and hashes: hashing or stringifying a value with a
+   * cache drops the caches held below it. A const value computes the
+   * hash on each call and never writes to the tree.
+   */
+  uint64_t GetHash() const;
+  uint64_t GetHash();
 
-  // Stringify json values
-  ReturnValue Stringify(std::string &text) const;
+  // Parse json texts, flags are combinations of ParseFlag
+  ReturnValue Parse(const char *json, unsigned flags = kParseDefault);
+  // Parse json texts reusing the memory kept by the context
+  ReturnValue Parse(
+    const char *json,
+    ParserContext &context,
+    unsigned flags = kParseDefault);
+  // Parse a large top-level array on several threads, 0 means automatic
+  ReturnValue ParseParallel(
+    const char *json,
+    size_t threads = 0,
+    unsigned flags = kParseDefault);
+
+  /*
+   * Stringify json values, flags are combinations of StringifyFlag.
+   * With kStringifyCached the text of the tree is kept by its root
+   * container until the next call, and only what changed is written
+   * again: changes through the setters, Parse(), Swap(), the patch
+   * functions and GetString(), which counts as a change of the string.
+   * The changes are marked in the nodes, so one value of a tree,
+   * normally its root, keeps text: stringifying a value with
+   * kStringifyCached drops the caches held below it, and a value
+   * below keeps no text once one above is stringified again.
+   * A const value ignores the flag and never writes to the tree.
+   */
+  ReturnValue Stringify(
+    std::string &text,
+    unsigned flags = kStringifyDefault) const;
+  ReturnValue Stringify(
+    std::string &text,
+    unsigned flags = kStringifyDefault);
+  // Stringify on several threads, into one string or into separate buffers
+  ReturnValue StringifyParallel(
+    std::string &text,
+    size_t threads = 0,
+    unsigned flags = kStringifyDefault) const;
+  ReturnValue StringifyParallel(
+    std::vector<std::string> &parts,
+    size_t threads = 0,
+    unsigned flags = kStringifyDefault) const;
 
   // Prettify generated JSON string
-  ReturnValue Prettify(std::string &text, int indent = 0) const;
+  ReturnValue Prettify(
+    std::string &text,
+    int indent = 0,
+    unsigned flags = kStringifyDefault) const;
 
  private:
+  friend class ArrayReader;
+  friend class ParserContext;
+  friend class Patcher;
+  friend class Reader;
+  friend class SharedDocument;
+  friend class NodeCache;
+
+  enum Flag {
+    // The payload belongs to a ParserContext and is not deleted by Free()
+    kFlagBorrowed = 1,
+    // The number is stored exactly in _int64 or _uint64
+    kFlagInt64 = 2,
+    kFlagUint64 = 4,
+    // The number is kept as source text in _raw
+    kFlagRawNumber = 8,
+    // The node has several parents in a frozen tree, which do not free it
+    kFlagShared = 16,
+    // The text kept for the node by the cache of its tree is up to date,
+    // cleared by every change, see TinkerCache.cpp
+    kFlagCached = 32,
+    // The container also holds the text cache of its tree
+    kFlagCacheRoot = 64,
+    // The hash kept for the node by the cache of its tree is up to date,
+    // cleared by every change like kFlagCached, see TinkerCompare.cpp
+    kFlagHashed = 128,
+    // Flags describing the payload, cleared by Free()
+    kPayloadFlags = kFlagBorrowed | kFlagInt64 | kFlagUint64 |
+      kFlagRawNumber | kFlagCacheRoot
+  };
+
   void Free();
+  void ReleaseChildren(std::vector<Value *> &pending);
+  NumberValue ReadNumber() const;
+  const NumberValue& ConvertRawNumber() const;
+  void ConvertRawNumbers() const;
+  void CollectMemoryStats(
+    MemoryStats &stats,
+    std::unordered_set<const Value *> &shared) const;
+
+  /*
+   * An open array or object of the iterative parser,
+   * with the key of the member being parsed.
+   */
+  struct ParseFrame {
+    Value *value;
+    std::string key;
+  };
 
   // JSON text parser
-  void ParseWhitespace();
-  ReturnValue ParseValue();
-  ReturnValue ParseLiteral(const char *literal, Type type);
-  ReturnValue ParseNumber();
-  ReturnValue ParseRawString(std::string *str);
-  ReturnValue ParseString();
-  ReturnValue ParseArray();
-  ReturnValue ParseObject();
+  static Value* NewValue(ParserContext *context);
+  static std::string* NewString(ParserContext *context);
+  static RawNumber* NewRawNumber(ParserContext *context);
+  static std::vector<Value *>* NewArray(ParserContext *context);
+  static std::unordered_map<std::string, Value *>* NewObject(
+    ParserContext *context);
+  ReturnValue ParseRoot(
+    const char *json,
+    ParserContext *context,
+    unsigned flags);
+  static void ParseWhitespace(const char *&json);
+  ReturnValue ParseValue(
+    const char *&json,
+    ParserContext *context,
+    unsigned flags,
+    std::vector<ParseFrame> &stack,
+    size_t max_depth);
+  ReturnValue ParseLiteral(const char *&json, const char *literal, Type type);
+  ReturnValue ParseNumber(
+    const char *&json,
+    ParserContext *context,
+    unsigned flags);
+  static ReturnValue ParseRawString(
+    const char *&json,
+    std::string *str,
+    unsigned flags);
+  static ReturnValue ParseKey(
+    const char *&json,
+    std::string *key,
+    unsigned flags);
+  ReturnValue ParseString(
+    const char *&json,
+    ParserContext *context,
+    unsigned flags);
+
+  // Text and hashes kept for the nodes, see TinkerCache.cpp
+  typedef std::unordered_map<const Value *, uint64_t> KeptHashes;
+  NodeCache* GetCache();
+  KeptHashes* GetKeptHashes();
+  bool FindChanges(unsigned flag, size_t &nodes);
+  size_t DropCaches();
+  void DropCache();
+  void DeleteCacheRoot();
+  void MarkDirty();
+  ReturnValue StringifyCached(std::string &text, unsigned flags);
+  // Structural hashes, see TinkerCompare.cpp
+  struct HashFrame;
+  static NumberValue NormalizeNumber(const NumberValue &number);
+  uint64_t HashScalar() const;
+  uint64_t KeepHash(KeptHashes &kept);
 
   // JSON value stringifier
   ReturnValue StringifyLiteral(const char *literal, std::string &text) const;
   ReturnValue StringifyNumber(std::string &text) const;
-  ReturnValue StringifyString(std::string &text) const;
-  ReturnValue StringifyArray(std::string &text) const;
-  ReturnValue StringifyObject(std::string &text) const;
+  ReturnValue StringifyString(std::string &text, unsigned flags) const;
+  ReturnValue StringifyArray(std::string &text, unsigned flags) const;
+  ReturnValue StringifyObject(std::string &text, unsigned flags) const;
 
   // JSON value stringifier
-  ReturnValue PrettifyArray(std::string &text, int indent) const;
-  ReturnValue PrettifyObject(std::string &text, int indent) const;
+  ReturnValue PrettifyArray(
+    std::string &text,
+    int indent,
+    unsigned flags) const;
+  ReturnValue PrettifyObject(
+    std::string &text,
+    int indent,
+    unsigned flags) const;
 
   // Data members
   Type _type;
-  const char *_json;
+  unsigned _flags;
   union {
     std::unordered_map<std::string, Value *> *_object;
     std::vector<Value *> *_array;
     std::string *_string;
+    RawNumber *_raw;
     double _number;
+    int64_t _int64;
+    uint64_t _uint64;
   } _value;
 };
 }
@@ -1,12 +1,29 @@
+#include <tinker-json/TinkerContext.h>
+#include <tinker-json/TinkerCpu.h>
+#include <tinker-json/TinkerDocument.h>
+#include <tinker-json/TinkerMapper.h>
+#include <tinker-json/TinkerPatch.h>
+#include <tinker-json/TinkerProfiler.h>
+#include <tinker-json/TinkerStream.h>
+#include <tinker-json/TinkerValidator.h>
 #include <tinker-json/TinkerValue.h>
+#ifdef TINKER_JSON_ZLIB
+#include <tinker-json/TinkerGzip.h>
+#include <zlib.h>
+#endif
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -65,6 +82,7 @@ int gTestPass = 0;
     Value v;\
     TestEqualInt(error, v.Parse(json));\
     TestEqualInt(kNull, v.GetType());\
+    TestEqualInt(error, Validate(json, strlen(json)));\
   } while(0)
 
 #define TestString(expect, json)\
@@ -375,6 +393,1399 @@ static void TestStringifyObject() {
    * However, the Value trees of the two JSON texts are identical.
    */
   // TestRoundtrip("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
+  TestRoundtrip("{\"a\\\"b\\n\\u0001\":{\"\\\\\":[]}}");
+}
+
+static void TestStringifyAscii() {
+  Value v;
+  std::string json;
+  TestEqualInt(kOk, v.Parse("[\"caf\xC3\xA9 \xE2\x82\xAC\",\"\xF0\x9F\x98\x80\","
+    "\"plain text long enough to be scanned in chunks\\n\",\"\\uDC00\","
+    "{\"\xE3\x81\x82\":\"\xC3\"}]"));
+  TestEqualInt(kOk, v.Stringify(json, kStringifyEnsureAscii));
+  const char expect[] = "[\"caf\\u00E9 \\u20AC\",\"\\uD83D\\uDE00\","
+    "\"plain text long enough to be scanned in chunks\\n\","
+    "\"\\uFFFD\\uFFFD\\uFFFD\","
+    "{\"\\u3042\":\"\\uFFFD\"}]";
+  TestEqualString(expect, json.c_str(), json.length());
+
+  std::string pretty;
+  TestEqualInt(kOk, v[4].Prettify(pretty, 0, kStringifyEnsureAscii));
+  TestEqualString("{\n  \"\\u3042\": \"\\uFFFD\"\n}",
+    pretty.c_str(), pretty.length());
+
+  json.clear();
+  TestEqualInt(kOk, v.StringifyParallel(json, 4, kStringifyEnsureAscii));
+  TestEqualString(expect, json.c_str(), json.length());
+
+  Value copy;
+  TestEqualInt(kOk, copy.Parse(expect));
+  TestEqualString("caf\xC3\xA9 \xE2\x82\xAC", copy[0].GetString().c_str(),
+    copy[0].GetLength());
+  TestEqualString("\xF0\x9F\x98\x80", copy[1].GetString().c_str(),
+    copy[1].GetLength());
+}
+
+static void TestStringifyCached() {
+  Value v("{\"a\":[1,\"x\",{\"b\":true}],\"c\":\"\\u00e9\",\"d\":null}");
+  std::string expect, text;
+  // The text kept by v is the text of the whole tree
+  auto same = [&](unsigned flags) {
+    expect.clear();
+    text.clear();
+    v.Stringify(expect, flags);
+    TestEqualInt(kOk, v.Stringify(text, kStringifyCached | flags));
+    return expect == text;
+  };
+  TestTrue(same(kStringifyDefault));
+  TestTrue(same(kStringifyDefault));
+
+  // Changes through the setters are written again
+  v["a"][2]["b"].SetNumber(2);
+  v["d"].SetString("y", 1);
+  TestTrue(same(kStringifyDefault));
+  std::vector<Value *> elements(1, new Value("[]"));
+  v["a"].SetArray(elements);
+  TestTrue(same(kStringifyEnsureAscii));
+
+  // Patches mark the containers they change
+  Value patch("[{\"op\":\"move\",\"from\":\"/c\",\"path\":\"/a/0/0\"},"
+    "{\"op\":\"add\",\"path\":\"/e\",\"value\":[1,2]},"
+    "{\"op\":\"move\",\"from\":\"/e/0\",\"path\":\"/e/1\"}]");
+  TestEqualInt(kOk, ApplyPatch(v, patch));
+  TestTrue(same(kStringifyDefault));
+
+  // So are writes through GetString() and references kept across calls
+  Value &d = v["d"];
+  d.GetString() = "z";
+  TestTrue(same(kStringifyDefault));
+  TestEqualString("\"z\"", text.c_str() + text.find("\"z\""), 3);
+  d.SetNumber(3);
+  TestTrue(same(kStringifyDefault));
+  Value &e = v["e"];
+  Value other("{\"f\":[]}");
+  e.Swap(other);
+  TestTrue(same(kStringifyDefault));
+  e["f"].SetBoolean(true);
+  TestTrue(same(kStringifyDefault));
+
+  // A const value writes the whole text and keeps nothing
+  const Value &constant = v;
+  text.clear();
+  TestEqualInt(kOk, constant.Stringify(text, kStringifyCached));
+  TestTrue(expect == text);
+  Value scalar("\"s\"");
+  text.clear();
+  TestEqualInt(kOk, scalar.Stringify(text, kStringifyCached));
+  TestEqualString("\"s\"", text.c_str(), text.length());
+
+  // A subtree and its root both stringified with kStringifyCached
+  Value w("{\"a\":{\"b\":[1,2]}}");
+  std::string whole, part;
+  w["a"].Stringify(part, kStringifyCached);
+  w["a"]["b"][0].SetNumber(5);
+  w.Stringify(whole, kStringifyCached);
+  TestTrue(whole == "{\"a\":{\"b\":[5,2]}}");
+  part.clear();
+  w["a"].Stringify(part, kStringifyCached);
+  TestTrue(part == "{\"b\":[5,2]}");
+  w["a"]["b"][1].SetNumber(6);
+  part.clear();
+  w["a"].Stringify(part, kStringifyCached);
+  TestTrue(part == "{\"b\":[5,6]}");
+  whole.clear();
+  w.Stringify(whole, kStringifyCached);
+  TestTrue(whole == "{\"a\":{\"b\":[5,6]}}");
+
+}
+
+static void TestParseParallel() {
+  std::string json = "[";
+  for(int i = 0; i < 1000; ++i) {
+    if(i > 0) json += " , ";
+    json += "{\"id\":" + std::to_string(i) + "}";
+    json += ",\"a,]\\\"[\", [ " + std::to_string(i) + " , { } ] ";
+  }
+  json += "]";
+  Value sequential, parallel;
+  std::string expect, actual;
+  TestEqualInt(kOk, sequential.Parse(json.c_str()));
+  TestEqualInt(kOk, parallel.ParseParallel(json.c_str(), 4));
+  TestEqualInt(3000, parallel.GetArraySize());
+  sequential.Stringify(expect);
+  parallel.Stringify(actual);
+  TestTrue(expect == actual);
+
+  TestEqualInt(kOk, parallel.ParseParallel(" [ ] ", 4));
+  TestEqualInt(0, parallel.GetArraySize());
+  TestEqualInt(kOk, parallel.ParseParallel("{\"a\":[1,2]}", 4));
+  TestEqualInt(kObject, parallel.GetType());
+
+  Value v;
+  TestEqualInt(kInvalidValue, v.ParseParallel("[1,2,,3,4,5,6]", 4));
+  TestEqualInt(kNull, v.GetType());
+  TestEqualInt(kMissCommaOrSquareBracket, v.ParseParallel("[1,2,3,4 5,6]", 4));
+  TestEqualInt(kMissCommaOrSquareBracket, v.ParseParallel("[1,2,3,4,5,6", 4));
+  TestEqualInt(kNotSingular, v.ParseParallel("[1,2,3,4,5,6] x", 4));
+  TestEqualInt(kMissQuotationMark, v.ParseParallel("[1,2,3,\"4,5,6]", 4));
+  // A trailing comma, before a split or in the last range
+  const char *trailing[] = {"[1, ]", "[1,2,3,4,5,6, ]", "[[1],{},\"a\" ,]"};
+  for(size_t i = 0; i < sizeof(trailing) / sizeof(trailing[0]); ++i) {
+    for(size_t threads = 2; threads <= 8; threads *= 2) {
+      TestEqualInt(kInvalidValue, v.ParseParallel(trailing[i], threads));
+    }
+  }
+}
+
+static void TestStringifyParallel() {
+  const char *json[] = {
+    "null",
+    "[]",
+    "{}",
+    "[1,[2,[3,[]]],{\"a\":{\"b\":[4,5,6]}},\"\\u00e9\\n\"]",
+    "{\"statuses\":[{\"id\":1},{\"id\":2},{\"id\":3}],\"meta\":{}}",
+  };
+  for(size_t i = 0; i < sizeof(json) / sizeof(json[0]); ++i) {
+    Value v;
+    std::string expect, actual;
+    std::vector<std::string> parts;
+    TestEqualInt(kOk, v.Parse(json[i]));
+    v.Stringify(expect);
+    TestEqualInt(kOk, v.StringifyParallel(actual, 4));
+    TestTrue(expect == actual);
+    TestEqualInt(kOk, v.StringifyParallel(parts, 3));
+    actual.clear();
+    for(size_t j = 0; j < parts.size(); ++j) {
+      actual += parts[j];
+    }
+    TestTrue(expect == actual);
+  }
+
+  // Long containers are split into ranges, a lone one into its children
+  std::string items;
+  for(int i = 0; i < 1000; ++i) {
+    items += (i == 0 ? "" : ",");
+    items += "{\"k" + std::to_string(i) + "\":[" + std::to_string(i) + "]}";
+  }
+  std::string large[] = {
+    "[" + items + "]",
+    "[[" + items + "]]",
+    "{\"outer\":{\"inner\":[" + items + "]},\"tail\":[]}",
+    "[1,[" + items + "],{\"a\":[" + items + "]}]",
+  };
+  for(size_t i = 0; i < sizeof(large) / sizeof(large[0]); ++i) {
+    Value v;
+    std::string expect, actual;
+    TestEqualInt(kOk, v.Parse(large[i].c_str()));
+    v.Stringify(expect);
+    for(size_t threads = 2; threads <= 16; threads *= 2) {
+      actual.clear();
+      TestEqualInt(kOk, v.StringifyParallel(actual, threads));
+      TestTrue(expect == actual);
+    }
+  }
+}
+
+static void TestSharedDocument() {
+  SharedDocument document;
+  TestEqualInt(kNull, document.Load()->GetType());
+  TestEqualInt(kOk, document.Parse("{\"version\":1,\"items\":[1,2,3]}"));
+  SharedDocument::Snapshot old = document.Load();
+  TestEqualDouble(1.0, (*old)["version"].GetNumber());
+
+  TestEqualInt(kMissCommaOrCurlyBracket, document.Parse("{\"version\":2"));
+  TestTrue(old == document.Load());
+
+  Value v("{\"version\":2,\"items\":[0,0]}");
+  TestEqualInt(kOk, document.Publish(v));
+  TestEqualInt(kNull, v.GetType());
+  TestEqualDouble(2.0, document.Load()->GetValue("version").GetNumber());
+  TestEqualDouble(1.0, old->GetValue("version").GetNumber());
+  TestEqualInt(3, old->GetValue("items").GetArraySize());
+
+  std::vector<std::thread> readers;
+  std::vector<int> mismatches(4, 0);
+  for(int i = 0; i < 4; ++i) {
+    readers.emplace_back([&document, &mismatches, i]() {
+      for(int j = 0; j < 1000; ++j) {
+        SharedDocument::Snapshot snapshot = document.Load();
+        double version = snapshot->GetValue("version").GetNumber();
+        if(snapshot->GetValue("items").GetArraySize() != (size_t)version) {
+          mismatches[i]++;
+        }
+      }
+    });
+  }
+  for(int i = 3; i < 100; ++i) {
+    std::string json = "{\"version\":" + std::to_string(i) + ",\"items\":[";
+    for(int j = 0; j < i; ++j) {
+      json += (j == 0 ? "0" : ",0");
+    }
+    json += "]}";
+    document.Parse(json.c_str());
+  }
+  for(size_t i = 0; i < readers.size(); ++i) {
+    readers[i].join();
+  }
+  for(size_t i = 0; i < mismatches.size(); ++i) {
+    TestEqualInt(0, mismatches[i]);
+  }
+
+  // Versions no reader holds are released, threads reuse the records
+  old = document.Load();
+  SharedDocument::Snapshot next = std::make_shared<const Value>("[1]");
+  TestTrue(document.Exchange(next) == old);
+  TestEqualInt(1, (int)old.use_count());
+  for(int i = 0; i < 8; ++i) {
+    std::thread reader([&document, &next]() {
+      TestTrue(document.Load() == next);
+    });
+    reader.join();
+  }
+  document.Store(old);
+  TestEqualInt(1, (int)next.use_count());
+
+  // Snapshots only give const references, raw numbers are converted
+  static_assert(std::is_same<decltype((*old)["items"][0]),
+    const Value&>::value, "const element");
+  static_assert(std::is_same<decltype(old->GetElement(0).GetString()),
+    const std::string&>::value, "const string");
+  Value raw;
+  TestEqualInt(kOk, raw.Parse("[1.5,2.5,\"x\",{\"y\":4}]", kParseRawNumbers));
+  SharedDocument::Snapshot frozen;
+  TestEqualInt(kOk, SharedDocument::Freeze(raw, frozen));
+  std::vector<double> sums(4, 0);
+  readers.clear();
+  for(int i = 0; i < 4; ++i) {
+    readers.emplace_back([&frozen, &sums, i]() {
+      for(const Value &element : frozen->GetElements()) {
+        if(element.GetType() == kNumber) {
+          sums[i] += element.GetNumber();
+        }
+      }
+      sums[i] += (*frozen)[3]["y"].GetNumber();
+    });
+  }
+  for(size_t i = 0; i < readers.size(); ++i) {
+    readers[i].join();
+    TestEqualDouble(8.0, sums[i]);
+  }
+
+  // Trees parsed with a ParserContext are left in place
+  ParserContext context;
+  Value borrowed;
+  TestEqualInt(kOk, borrowed.Parse("{\"version\":0}", context));
+  TestEqualInt(kContextOwned, SharedDocument::Freeze(borrowed, frozen));
+  TestEqualInt(kContextOwned, document.Publish(borrowed));
+  TestEqualInt(kObject, borrowed.GetType());
+  TestTrue(old == document.Load());
+  TestEqualInt(kContextOwned,
+    SharedDocument::Freeze(borrowed, frozen, kFreezeDeduplicate));
+}
+
+static void TestDeduplicate() {
+  const char *json = "{\"areas\":[{\"id\":1,\"name\":\"x\"},"
+    "{\"id\":1,\"name\":\"x\"},{\"name\":\"x\",\"id\":1}],"
+    "\"prices\":[[1,2],[1,2],[1,-0],[1,0]],"
+    "\"s\":\"a long string shared by several members\","
+    "\"t\":\"a long string shared by several members\"}";
+  Value v(json);
+  std::string expect;
+  v.Stringify(expect);
+  DedupStats stats;
+  SharedDocument::Snapshot snapshot;
+  TestEqualInt(kOk,
+    SharedDocument::Freeze(v, snapshot, kFreezeDeduplicate, &stats));
+  TestEqualInt(kNull, v.GetType());
+  // Equal objects share the member order of the first one
+  std::string text;
+  snapshot->Stringify(text);
+  TestEqualInt(expect.length(), text.length());
+
+  const Value &root = *snapshot;
+  TestTrue(&root["areas"][0] == &root["areas"][2]);
+  TestTrue(&root["areas"][0]["id"] == &root["prices"][3][0]);
+  TestTrue(&root["prices"][0] == &root["prices"][1]);
+  TestTrue(&root["prices"][2] != &root["prices"][3]);
+  TestTrue(&root["s"] == &root["t"]);
+  TestEqualInt(13, stats.removed_nodes);
+  TestEqualInt(4, stats.shared_nodes);
+  TestTrue(stats.bytes_after < stats.bytes_before);
+  TestEqualInt(stats.bytes_after, snapshot->GetMemoryStats().total_bytes);
+
+  SharedDocument document;
+  Value next("[[true],[true]]");
+  TestEqualInt(kOk, document.Publish(next, kFreezeDeduplicate));
+  TestTrue(&(*document.Load())[0] == &(*document.Load())[1]);
+}
+
+// Applies the patch and checks the document against expect with Diff()
+static void TestApplyPatch(
+  const char *document,
+  const char *patch,
+  ReturnValue result,
+  const char *expect) {
+  Value v(document);
+  Value p(patch);
+  Value e(expect);
+  Value d;
+  TestEqualInt(result, ApplyPatch(v, p));
+  TestEqualInt(kOk, Diff(v, e, d));
+  TestEqualInt(0, d.GetArraySize());
+}
+
+static void TestDiff(const char *source, const char *target, size_t size) {
+  Value v(source);
+  Value t(target);
+  Value d;
+  TestEqualInt(kOk, Diff(v, t, d));
+  TestEqualInt(size, d.GetArraySize());
+  TestEqualInt(kOk, ApplyPatch(v, d));
+  Value e;
+  TestEqualInt(kOk, Diff(v, t, e));
+  TestEqualInt(0, e.GetArraySize());
+}
+
+static void TestPatch() {
+  // RFC 6902 appendix A
+  TestApplyPatch("{\"foo\":\"bar\"}",
+    "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\"}]",
+    kOk, "{\"baz\":\"qux\",\"foo\":\"bar\"}");
+  TestApplyPatch("{\"foo\":[\"bar\",\"baz\"]}",
+    "[{\"op\":\"add\",\"path\":\"/foo/1\",\"value\":\"qux\"}]",
+    kOk, "{\"foo\":[\"bar\",\"qux\",\"baz\"]}");
+  TestApplyPatch("{\"baz\":\"qux\",\"foo\":\"bar\"}",
+    "[{\"op\":\"remove\",\"path\":\"/baz\"}]", kOk, "{\"foo\":\"bar\"}");
+  TestApplyPatch("{\"baz\":\"qux\",\"foo\":\"bar\"}",
+    "[{\"op\":\"replace\",\"path\":\"/baz\",\"value\":\"boo\"}]",
+    kOk, "{\"baz\":\"boo\",\"foo\":\"bar\"}");
+  TestApplyPatch("[1,2]",
+    "[{\"op\":\"replace\",\"path\":\"/1\",\"value\":3}]", kOk, "[1,3]");
+  TestApplyPatch(
+    "{\"foo\":{\"bar\":\"baz\",\"waldo\":\"fred\"},\"qux\":{\"corge\":1}}",
+    "[{\"op\":\"move\",\"from\":\"/foo/waldo\",\"path\":\"/qux/thud\"}]",
+    kOk, "{\"foo\":{\"bar\":\"baz\"},\"qux\":{\"corge\":1,\"thud\":\"fred\"}}");
+  TestApplyPatch("{\"foo\":[\"all\",\"grass\",\"cows\",\"eat\"]}",
+    "[{\"op\":\"move\",\"from\":\"/foo/1\",\"path\":\"/foo/3\"}]",
+    kOk, "{\"foo\":[\"all\",\"cows\",\"eat\",\"grass\"]}");
+  TestApplyPatch("{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}",
+    "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"qux\"},"
+    "{\"op\":\"test\",\"path\":\"/foo/1\",\"value\":2.0}]",
+    kOk, "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}");
+  TestApplyPatch("{\"foo\":[\"bar\"]}",
+    "[{\"op\":\"add\",\"path\":\"/foo/-\",\"value\":[\"abc\",\"def\"]}]",
+    kOk, "{\"foo\":[\"bar\",[\"abc\",\"def\"]]}");
+  TestApplyPatch("{\"/\":0,\"~\":1}",
+    "[{\"op\":\"copy\",\"from\":\"/~1\",\"path\":\"/~0\"}]",
+    kOk, "{\"/\":0,\"~\":0}");
+  TestApplyPatch("{\"a\":1}",
+    "[{\"op\":\"replace\",\"path\":\"\",\"value\":[1]}]", kOk, "[1]");
+
+  // A failed operation rolls back the whole patch
+  TestApplyPatch("{\"a\":[1,2],\"b\":{\"c\":3}}",
+    "[{\"op\":\"remove\",\"path\":\"/a/0\"},"
+    "{\"op\":\"move\",\"from\":\"/b/c\",\"path\":\"/a/-\"},"
+    "{\"op\":\"replace\",\"path\":\"\",\"value\":null},"
+    "{\"op\":\"test\",\"path\":\"\",\"value\":0}]",
+    kPatchTestFailed, "{\"a\":[1,2],\"b\":{\"c\":3}}");
+  TestApplyPatch("{\"a\":[1]}",
+    "[{\"op\":\"add\",\"path\":\"/a/0\",\"value\":0},"
+    "{\"op\":\"add\",\"path\":\"/a/3\",\"value\":0}]",
+    kPathNotFound, "{\"a\":[1]}");
+  TestApplyPatch("{\"a\":{\"b\":1}}",
+    "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/a/c\"}]",
+    kInvalidPatch, "{\"a\":{\"b\":1}}");
+  TestApplyPatch("{\"a\":[1]}",
+    "[{\"op\":\"remove\",\"path\":\"/a/01\"}]", kPathNotFound, "{\"a\":[1]}");
+  TestApplyPatch("{}", "[{\"op\":\"add\",\"path\":\"a\",\"value\":1}]",
+    kInvalidPatch, "{}");
+  TestApplyPatch("{}", "[{\"op\":\"add\",\"path\":\"/a\"}]",
+    kInvalidPatch, "{}");
+  TestApplyPatch("{}", "[{\"op\":\"remove\",\"path\":\"/a\"}]",
+    kPathNotFound, "{}");
+  TestApplyPatch("{}", "{}", kInvalidPatch, "{}");
+
+  // The values of the patch are moved, and put back on failure
+  Value v("{\"a\":1}");
+  Value p("[{\"op\":\"add\",\"path\":\"/b\",\"value\":[2]},"
+    "{\"op\":\"remove\",\"path\":\"/c\"}]");
+  TestEqualInt(kPathNotFound, ApplyPatch(v, p));
+  TestEqualInt(kArray, p[0]["value"].GetType());
+  p[1]["path"].SetString("/a", 2);
+  TestEqualInt(kOk, ApplyPatch(v, p));
+  TestEqualInt(1, v.GetObjectSize());
+  TestEqualInt(2, v["b"][0].GetNumber());
+
+  // RFC 7396 example
+  Value m("{\"title\":\"Goodbye!\",\"author\":{\"givenName\":\"John\","
+    "\"familyName\":\"Doe\"},\"tags\":[\"example\",\"sample\"],"
+    "\"content\":\"This will be unchanged\"}");
+  Value mp("{\"title\":\"Hello!\",\"phoneNumber\":\"+01-123-456-7890\","
+    "\"author\":{\"familyName\":null},\"tags\":[\"example\"]}");
+  Value me("{\"title\":\"Hello!\",\"author\":{\"givenName\":\"John\"},"
+    "\"tags\":[\"example\"],\"content\":\"This will be unchanged\","
+    "\"phoneNumber\":\"+01-123-456-7890\"}");
+  Value md;
+  TestEqualInt(kOk, ApplyMergePatch(m, mp));
+  TestEqualInt(kOk, Diff(m, me, md));
+  TestEqualInt(0, md.GetArraySize());
+  Value scalar("[1]");
+  Value sp("{\"a\":{\"b\":null,\"c\":true}}");
+  TestEqualInt(kOk, ApplyMergePatch(scalar, sp));
+  TestEqualInt(kTrue, scalar["a"]["c"].GetType());
+  TestEqualInt(1, scalar["a"].GetObjectSize());
+
+  // The nodes of a tree parsed with a context are not the patch's to free
+  ParserContext context;
+  Value owned;
+  TestEqualInt(kOk, owned.Parse("{\"a\":{\"b\":1},\"c\":2}", context));
+  Value cp("{\"c\":null}");
+  TestEqualInt(kContextOwned, ApplyMergePatch(owned, cp));
+  TestEqualInt(2, owned["c"].GetNumber());
+  TestEqualInt(kNull, cp["c"].GetType());
+  Value rp("[{\"op\":\"remove\",\"path\":\"/c\"}]");
+  TestEqualInt(kContextOwned, ApplyPatch(owned, rp));
+  TestEqualInt(2, owned.GetObjectSize());
+  Value target("{\"a\":{\"b\":1}}");
+  TestEqualInt(kContextOwned, ApplyMergePatch(target, owned));
+  TestEqualInt(kContextOwned, ApplyPatch(target, owned));
+
+  TestDiff("{\"a\":1,\"b\":[1,2,3]}", "{\"a\":1,\"b\":[1,2,3]}", 0);
+  TestDiff("{\"a\":1,\"b\":2}", "{\"a\":1.0,\"c\":2}", 2);
+  TestDiff("[1,2,3,4,5]", "[1,3,4,6,5]", 2);
+  TestDiff("[1,2,3]", "[]", 3);
+  TestDiff("[[1,2],{\"k\":\"v\"}]", "[[1,3],{\"k\":\"w\"},0]", 3);
+  TestDiff("{\"a/b\":{\"~\":1}}", "{\"a/b\":{\"~\":2}}", 1);
+  TestDiff("[1,2]", "{\"a\":[1,2]}", 1);
+
+  // Deep trees are diffed without recursion
+  Value deep;
+  Value other;
+  deep.SetNumber(1);
+  other.SetNumber(2);
+  for(int i = 0; i < 100000; ++i) {
+    Value *inner = new Value();
+    inner->Swap(deep);
+    std::unordered_map<std::string, Value *> members;
+    members["a"] = inner;
+    deep.SetObject(members);
+    inner = new Value();
+    inner->Swap(other);
+    members["a"] = inner;
+    other.SetObject(members);
+  }
+  Value changes;
+  TestEqualInt(kOk, Diff(deep, other, changes));
+  TestEqualInt(1, changes.GetArraySize());
+  TestEqualInt(200000, changes[0]["path"].GetString().length());
+}
+
+static void TestCompare() {
+  Value v("{\"a\":[1,2.5,\"x\"],\"b\":{\"c\":null,\"d\":true},\"e\":-0}");
+  Value w("{\"e\":0.0,\"b\":{\"d\":true,\"c\":null},\"a\":[1.0,2.5,\"x\"]}");
+  Value x("{\"a\":[2.5,1,\"x\"],\"b\":{\"c\":null,\"d\":true},\"e\":0}");
+  TestTrue(v == w);
+  TestTrue(v != x);
+  TestTrue(v.GetHash() == w.GetHash());
+  TestTrue(v.GetHash() != x.GetHash());
+  TestTrue(Value("9007199254740993") != Value("9007199254740992.0"));
+  TestTrue(Value("[1,2]") != Value("[1,2,3]"));
+  TestTrue(Value("{\"a\":1}") != Value("{\"b\":1}"));
+  TestTrue(Value("\"1\"") != Value("1"));
+
+  // Hashes follow the changes, also those made through references
+  uint64_t hash = v.GetHash();
+  v["b"]["c"].SetNumber(1);
+  TestTrue(v.GetHash() != hash);
+  TestTrue(v != w);
+  w["b"]["c"].SetInt64(1);
+  TestTrue(v.GetHash() == w.GetHash());
+  TestTrue(v == w);
+  Value patch("[{\"op\":\"remove\",\"path\":\"/a/1\"}]");
+  TestEqualInt(kOk, ApplyPatch(w, patch));
+  TestTrue(v != w);
+  const Value &items = w["a"];
+  TestTrue(Value("[1,\"x\"]").GetHash() == items.GetHash());
+  Value a("{\"k\":\"x\",\"n\":[1]}");
+  Value b("{\"k\":\"y\",\"n\":[1]}");
+  TestTrue(a.GetHash() != b.GetHash());
+  TestTrue(a != b);
+  a["k"].GetString() = "y";
+  TestTrue(a.GetHash() == b.GetHash());
+  TestTrue(a == b);
+  Value changes;
+  TestEqualInt(kOk, Diff(a, b, changes));
+  TestEqualInt(0, changes.GetArraySize());
+  Value check("[{\"op\":\"test\",\"path\":\"\",\"value\":{\"n\":[1],\"k\":\"y\"}}]");
+  TestEqualInt(kOk, ApplyPatch(a, check));
+
+  // Kept hashes are refreshed after writes deep in the tree
+  Value deep("{\"a\":[{\"s\":\"one\"},[\"two\",3]],\"b\":\"four\"}");
+  Value other("{\"a\":[{\"s\":\"one\"},[\"two\",3]],\"b\":\"four\"}");
+  const Value &fresh = deep;
+  TestTrue(deep.GetHash() == fresh.GetHash());
+  TestTrue(deep.GetHash() == other.GetHash());
+  TestTrue(deep == other);
+  deep["a"][1][0].GetString() = "TWO";
+  TestTrue(deep.GetHash() == fresh.GetHash());
+  TestTrue(deep.GetHash() != other.GetHash());
+  TestTrue(deep != other);
+  other["a"][1][0].GetString() = "TWO";
+  TestTrue(deep == other);
+  TestTrue(deep.GetHash() == other.GetHash());
+  deep["a"][0]["s"].GetString() += "!";
+  TestTrue(deep != other);
+  TestTrue(deep.GetHash() == fresh.GetHash());
+  deep["a"][0]["s"].SetString("one", 3);
+  deep["b"].SetNumber(4);
+  TestTrue(deep.GetHash() == fresh.GetHash());
+  TestTrue(deep != other);
+
+  // A subtree hashed before its root does not keep a stale hash
+  Value root("{\"a\":{\"b\":[1,2],\"c\":\"x\"}}");
+  Value equal("{\"b\":[5,2],\"c\":\"x\"}");
+  const Value &part = root["a"];
+  root["a"].GetHash();
+  root["a"]["b"][0].SetNumber(5);
+  root.GetHash();
+  equal.GetHash();
+  TestTrue(root["a"].GetHash() == part.GetHash());
+  TestTrue(root["a"].GetHash() == equal.GetHash());
+  TestTrue(root["a"] == equal);
+  root["a"]["c"].SetString("y", 1);
+  TestTrue(root["a"].GetHash() == part.GetHash());
+  TestTrue(root.GetHash() == static_cast<const Value &>(root).GetHash());
+  TestTrue(root["a"] != equal);
+
+  // Deep trees are hashed without recursion
+  Value nested;
+  std::vector<Value *> elements;
+  for(int i = 0; i < 100000; ++i) {
+    Value *inner = new Value();
+    inner->Swap(nested);
+    elements.assign(1, inner);
+    nested.SetArray(elements);
+  }
+  const Value &unkept = nested;
+  TestTrue(nested.GetHash() == unkept.GetHash());
+}
+
+static void TestIterate() {
+  Value v("{\"a\":[1,2,3],\"b\":{\"c\":4},\"d\":[]}");
+  int64_t sum = 0;
+  for(Value &element : v["a"].GetElements()) {
+    sum += element.GetInt64();
+  }
+  TestEqualInt(6, sum);
+  for(Value &element : v["d"].GetElements()) {
+    sum += element.GetInt64();
+  }
+  TestEqualInt(6, sum);
+
+  std::string keys;
+  int members = 0;
+  for(Value::Member member : v.GetMembers()) {
+    keys += member.key;
+    ++members;
+    if(member.key == "b") {
+      TestEqualInt(4, member.value["c"].GetInt64());
+    }
+  }
+  TestEqualInt(3, members);
+  TestEqualInt(3, keys.length());
+
+  // Elements are changed in place
+  for(Value &element : v["a"].GetElements()) {
+    element.SetInt64(element.GetInt64() * 10);
+  }
+  TestEqualInt(30, v["a"][2].GetInt64());
+  Value::ElementIterator it = v["a"].GetElements().begin();
+  TestEqualInt(10, it->GetInt64());
+  ++it;
+  TestEqualInt(20, (*it).GetInt64());
+  TestEqualInt(20, (it++)->GetInt64());
+  TestEqualInt(30, it->GetInt64());
+
+  // With the algorithms of the standard library
+  Value::Range<Value::ElementIterator> elements = v["a"].GetElements();
+  TestEqualInt(3, (int)std::distance(elements.begin(), elements.end()));
+  Value::ElementIterator found = std::find_if(elements.begin(), elements.end(),
+    [](const Value &element) { return element.GetInt64() > 15; });
+  TestTrue(&*found == &v["a"][1]);
+  TestTrue(std::max_element(elements.begin(), elements.end(),
+    [](const Value &a, const Value &b) {
+      return a.GetInt64() < b.GetInt64();
+    }) == ++found);
+  std::vector<int64_t> copied;
+  std::transform(elements.begin(), elements.end(), std::back_inserter(copied),
+    [](const Value &element) { return element.GetInt64(); });
+  TestEqualInt(3, (int)copied.size());
+  TestEqualInt(30, copied[2]);
+
+  const Value &constant = v;
+  Value::Range<Value::ConstMemberIterator> all = constant.GetMembers();
+  TestEqualInt(3, (int)std::distance(all.begin(), all.end()));
+  Value::ConstMemberIterator member = std::find_if(all.begin(), all.end(),
+    [](Value::ConstMember m) { return m.value.GetType() == kObject; });
+  TestTrue(member->key == "b");
+  TestEqualInt(4, member->value["c"].GetInt64());
+  TestEqualInt(2, (int)std::count_if(all.begin(), all.end(),
+    [](Value::ConstMember m) { return m.value.GetType() == kArray; }));
+  TestTrue(member++ != all.end());
+}
+
+static void TestFind() {
+  Value v("{\"name\":\"x\",\"a key longer than any short string\":1,\"n\":null}");
+  TestTrue(v.Find("name") == &v["name"]);
+  TestTrue(v.Find(std::string("n")) == &v["n"]);
+  TestTrue(v.Find("name", 2) == nullptr);
+  TestTrue(v.Find("missing") == nullptr);
+  TestTrue(v["name"].Find("name") == nullptr);
+  TestEqualInt(1, v["a key longer than any short string"].GetInt64());
+  TestTrue(v.HasKey("n"));
+  TestTrue(!v.HasKey("m"));
+
+  // A key finds its bucket again in objects of other sizes
+  Key key("id");
+  Value small("{\"id\":1}");
+  Value large("{\"a\":0,\"b\":0,\"c\":0,\"d\":0,\"e\":0,\"f\":0,\"g\":0,"
+    "\"h\":0,\"i\":0,\"j\":0,\"k\":0,\"l\":0,\"m\":0,\"id\":2}");
+  Value other("{\"di\":3}");
+  for(int i = 0; i < 2; ++i) {
+    TestEqualInt(1, small[key].GetInt64());
+    TestEqualInt(2, large[key].GetInt64());
+    TestTrue(other.Find(key) == nullptr);
+    TestTrue(!other.HasKey(key));
+  }
+  TestTrue(Value("{}").Find(key) == nullptr);
+  TestTrue(Value("[1]").Find(key) == nullptr);
+  TestEqualString("id", key.GetText().c_str(), key.GetText().length());
+
+  // And in objects of every size up to a few rehashes
+  std::string text = "{";
+  std::vector<Key> keys;
+  for(int i = 0; i < 300; ++i) {
+    std::string name = "k" + std::to_string(i);
+    keys.push_back(Key(name));
+    text += (i == 0 ? "\"" : ",\"") + name + "\":" + std::to_string(i);
+    Value growing((text + "}").c_str());
+    for(int j = 0; j <= i; j += 7) {
+      const Value *found = growing.Find(keys[j]);
+      TestTrue(found != nullptr && found->GetInt64() == j);
+    }
+    TestTrue(growing.Find(key) == nullptr);
+  }
+}
+
+// Reads the array at path one byte at a time, returns the result
+static ReturnValue ReadBytes(const char *json, const char *path, int &count,
+                             unsigned flags = kParseDefault) {
+  size_t offset = 0;
+  ArrayReader reader([&](char *buffer, size_t size) -> size_t {
+    if(size == 0 || json[offset] == '\0') {
+      return 0;
+    }
+    buffer[0] = json[offset++];
+    return 1;
+  }, path, flags);
+  count = 0;
+  for(Value &item : reader) {
+    (void)item;
+    ++count;
+  }
+  return reader.GetResult();
+}
+
+static void TestArrayReader() {
+  const char *json = " {\"meta\":{},\"items\":[1, \"two\", [3], {\"four\":4}, null]} ";
+  ArrayReader reader(json, "/items");
+  Value element;
+  std::string str;
+  while(reader.Next(element)) {
+    element.Stringify(str);
+  }
+  TestEqualInt(kOk, reader.GetResult());
+  TestEqualString("1\"two\"[3]{\"four\":4}null", str.c_str(), str.length());
+  TestTrue(element.GetType() == kNull);
+
+  // The same text, read one byte at a time
+  size_t offset = 0;
+  ArrayReader chunked([&](char *buffer, size_t size) -> size_t {
+    if(size == 0 || json[offset] == '\0') {
+      return 0;
+    }
+    buffer[0] = json[offset++];
+    return 1;
+  }, "/items");
+  int count = 0;
+  for(Value &item : chunked) {
+    if(count == 3) {
+      TestEqualInt(4, item["four"].GetInt64());
+    }
+    ++count;
+  }
+  TestEqualInt(kOk, chunked.GetResult());
+  TestEqualInt(5, count);
+
+  ArrayReader nested("[[], [1, [2, 3]]]", "/1/1");
+  count = 0;
+  for(Value &item : nested) {
+    count += (int)item.GetInt64();
+  }
+  TestEqualInt(5, count);
+
+  ArrayReader empty("[]");
+  TestTrue(!empty.Next(element));
+  TestEqualInt(kOk, empty.GetResult());
+  ArrayReader missing(json, "/nothing");
+  TestTrue(!missing.Next(element));
+  TestEqualInt(kPathNotFound, missing.GetResult());
+  ArrayReader object(json, "/meta");
+  TestTrue(!object.Next(element));
+  TestEqualInt(kTypeMismatch, object.GetResult());
+  ArrayReader broken("[1, tru]");
+  TestTrue(broken.Next(element));
+  TestTrue(!broken.Next(element));
+  TestEqualInt(kInvalidValue, broken.GetResult());
+
+  // Trailing commas, as Parse() reports them
+  const char *trailing[][2] = {
+    {"[1,2,]", ""},
+    {"[1,2 , ]", ""},
+    {"{\"a\":[\"x\",]}", "/a"},
+  };
+  for(auto &text : trailing) {
+    ArrayReader whole(text[0], text[1]);
+    count = 0;
+    while(whole.Next(element)) {
+      ++count;
+    }
+    TestEqualInt(kInvalidValue, whole.GetResult());
+    TestEqualInt(kInvalidValue, ReadBytes(text[0], text[1], count));
+  }
+  TestEqualInt(kInvalidValue, ReadBytes("{\"a\":[1,],\"b\":[]}", "/b", count));
+  TestEqualInt(kMissKey, ReadBytes("{\"a\":{\"c\":1,},\"b\":[]}", "/b", count));
+
+  // Invalid UTF-8 in a key on the path to the array
+  const char *bad_key = "{\"\xC3\x28\":1,\"b\":[1]}";
+  TestEqualInt(kOk, ReadBytes(bad_key, "/b", count));
+  TestEqualInt(kInvalidUtf8,
+    ReadBytes(bad_key, "/b", count, kParseValidateUtf8));
+  ArrayReader whole_bad_key(bad_key, "/b", kParseValidateUtf8);
+  TestTrue(!whole_bad_key.Next(element));
+  TestEqualInt(kInvalidUtf8, whole_bad_key.GetResult());
+
+  // A sibling larger than many chunks is skipped a value at a time
+  std::string large = "{\"a\":[";
+  for(int i = 0; i < 10000; ++i) {
+    large += "{\"x\":[1,\"two\",null],\"y\":{}},";
+  }
+  large += "[]],\"b\":[1,2,3]}";
+  TestEqualInt(kOk, ReadBytes(large.c_str(), "/b", count));
+  TestEqualInt(3, count);
+}
+
+#ifdef TINKER_JSON_ZLIB
+// One gzip member holding text
+static std::string Gzip(const std::string &text) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+               Z_DEFAULT_STRATEGY);
+  std::string gzip(deflateBound(&stream, text.length()) + 32, '\0');
+  stream.next_in = (Bytef *)text.data();
+  stream.avail_in = (uInt)text.length();
+  stream.next_out = (Bytef *)&gzip[0];
+  stream.avail_out = (uInt)gzip.length();
+  deflate(&stream, Z_FINISH);
+  gzip.resize(stream.total_out);
+  deflateEnd(&stream);
+  return gzip;
+}
+
+// Sums the elements of /items read from gzip, in pieces of at most step
+static int64_t SumGzip(const std::string &gzip, size_t step, bool background,
+                       ReturnValue &result, uint64_t &offset) {
+  size_t position = 0;
+  GzipReader source([&](char *buffer, size_t size) -> size_t {
+    size_t count = std::min(std::min(size, step), gzip.length() - position);
+    memcpy(buffer, gzip.data() + position, count);
+    position += count;
+    return count;
+  }, background);
+  ArrayReader reader(source.GetReadFunction(), "/items");
+  int64_t sum = 0;
+  for(Value &item : reader) {
+    sum += item.GetInt64();
+  }
+  result = source.GetResult();
+  offset = source.GetOffset();
+  return sum;
+}
+
+static void TestGzip() {
+  // Larger than a few chunks once decompressed
+  std::string json = "{\"items\":[";
+  int64_t expect = 0;
+  for(int i = 0; i < 200000; ++i) {
+    json += (i == 0 ? "" : ",") + std::to_string(i);
+    expect += i;
+  }
+  json += "]}";
+  std::string gzip = Gzip(json);
+  ReturnValue result;
+  uint64_t offset;
+  for(int background = 0; background < 2; ++background) {
+    TestTrue(expect == SumGzip(gzip, 1000, background != 0, result, offset));
+    TestEqualInt(kOk, result);
+    TestTrue(offset == json.length());
+  }
+
+  // Concatenated members are one text
+  std::string members = Gzip("{\"items\":[1, 2,") + Gzip(" 3]}");
+  TestTrue(6 == SumGzip(members, 7, true, result, offset));
+  TestEqualInt(kOk, result);
+  TestTrue(6 == SumGzip(members, 7, false, result, offset));
+  TestEqualInt(kOk, result);
+
+  // A cut member, and bytes which are no gzip
+  SumGzip(gzip.substr(0, gzip.length() / 2), 1000, true, result, offset);
+  TestEqualInt(kInvalidGzip, result);
+  TestTrue(offset > 0 && offset < json.length());
+  SumGzip(gzip.substr(0, gzip.length() - 4), 1000, false, result, offset);
+  TestEqualInt(kInvalidGzip, result);
+  SumGzip(json, 1000, false, result, offset);
+  TestEqualInt(kInvalidGzip, result);
+  TestTrue(offset == 0);
+
+  // A malformed array is reported by the reader, not by the gzip source
+  for(int background = 0; background < 2; ++background) {
+    std::string malformed = Gzip("{\"items\":[1,2,]}");
+    size_t position = 0;
+    GzipReader source([&](char *buffer, size_t size) -> size_t {
+      size_t count = std::min(size, malformed.length() - position);
+      memcpy(buffer, malformed.data() + position, count);
+      position += count;
+      return count;
+    }, background != 0);
+    ArrayReader reader(source.GetReadFunction(), "/items");
+    int count = 0;
+    for(Value &item : reader) {
+      count += (int)item.GetInt64();
+    }
+    TestEqualInt(3, count);
+    TestEqualInt(kInvalidValue, reader.GetResult());
+    TestEqualInt(kOk, source.GetResult());
+  }
+
+  // Dropped while the thread is ahead
+  {
+    size_t position = 0;
+    GzipReader partial([&](char *buffer, size_t size) -> size_t {
+      size_t count = std::min(size, gzip.length() - position);
+      memcpy(buffer, gzip.data() + position, count);
+      position += count;
+      return count;
+    });
+    char prefix[11];
+    TestEqualInt(10, (int)partial.Read(prefix, 10));
+    prefix[10] = '\0';
+    TestEqualString("{\"items\":[", prefix, 10);
+  }
+
+  GzipReader missing("/nonexistent/dump.json.gz");
+  char buffer[16];
+  TestEqualInt(0, (int)missing.Read(buffer, sizeof(buffer)));
+  TestEqualInt(kReadFailed, missing.GetResult());
+}
+#endif
+
+static void TestMemoryStats() {
+  Value v;
+  TestEqualInt(kOk, v.Parse(
+    "[1,\"abc\",{\"k\":null,\"a very long key for the heap\":true},[]]"));
+  MemoryStats stats = v.GetMemoryStats();
+  TestEqualInt(2, stats.nodes[kArray]);
+  TestEqualInt(1, stats.nodes[kNumber]);
+  TestEqualInt(1, stats.nodes[kString]);
+  TestEqualInt(1, stats.nodes[kObject]);
+  TestEqualInt(1, stats.nodes[kNull]);
+  TestEqualInt(1, stats.nodes[kTrue]);
+  TestEqualInt(7 * sizeof(Value), stats.node_bytes);
+  TestTrue(stats.key_bytes > 0);
+  TestTrue(stats.string_bytes >= sizeof(std::string));
+  TestEqualInt(stats.node_bytes + stats.string_bytes +
+    stats.container_bytes + stats.key_bytes, stats.total_bytes);
+
+  // A tree as deep as the parser allows
+  std::string deep = std::string(kDefaultMaxDepth, '[') +
+    std::string(kDefaultMaxDepth, ']');
+  Value nested;
+  TestEqualInt(kOk, nested.Parse(deep.c_str()));
+  TestEqualInt(kDefaultMaxDepth, nested.GetMemoryStats().nodes[kArray]);
+
+  CountingAllocator allocator;
+  SetAllocator(&allocator);
+  {
+    Value counted;
+    TestEqualInt(kOk, counted.Parse("[1,[2,3],{\"k\":[4]}]"));
+    TestEqualInt(7, allocator.GetAllocations());
+    TestEqualInt(7 * sizeof(Value), allocator.GetLiveBytes());
+  }
+  TestEqualInt(7, allocator.GetDeallocations());
+  TestEqualInt(0, allocator.GetLiveBytes());
+  SetAllocator(nullptr);
+}
+
+static void TestParserStats() {
+  ResetParserStats();
+  Value v;
+  TestEqualInt(kOk, v.Parse(" {\"a\" : [1, 2.5, \"x\", true, null], \"b\" : {}} "));
+  ParserStats stats = GetParserStats();
+  if(IsParserProfilingEnabled()) {
+    TestEqualInt(2, stats.tokens[kNumber]);
+    TestEqualInt(1, stats.tokens[kString]);
+    TestEqualInt(1, stats.tokens[kTrue]);
+    TestEqualInt(1, stats.tokens[kNull]);
+    TestEqualInt(1, stats.tokens[kArray]);
+    TestEqualInt(2, stats.tokens[kObject]);
+    TestEqualInt(2, stats.keys);
+    TestEqualInt(1, stats.calls[kPhaseParse]);
+    TestEqualInt(4, stats.bytes[kPhaseNumber]);
+    TestEqualInt(9, stats.bytes[kPhaseString]);
+    TestTrue(stats.cycles[kPhaseParse] >= stats.cycles[kPhaseNumber]);
+  } else {
+    TestEqualInt(0, stats.calls[kPhaseParse]);
+    TestEqualInt(0, stats.tokens[kObject]);
+  }
+}
+
+static void TestParseContext() {
+  ParserContext context;
+  Value v;
+  const char *json = "{\"id\":1,\"tags\":[\"a\",\"b\"],\"user\":{\"name\":\"x\"}}";
+  TestEqualInt(kOk, v.Parse(json, context));
+  TestEqualInt(kObject, v.GetType());
+  TestEqualString("x", v["user"]["name"].GetString().c_str(), 1);
+  size_t nodes = context.GetNodeCapacity();
+  size_t strings = context.GetStringCapacity();
+  const Value *tags = &v["tags"];
+
+  for(int i = 0; i < 10; ++i) {
+    TestEqualInt(kOk, v.Parse(json, context));
+  }
+  TestTrue(tags == &v["tags"]);
+  TestEqualInt(2, v["tags"].GetArraySize());
+  TestEqualString("b", v["tags"][1].GetString().c_str(), 1);
+  TestEqualInt(nodes, context.GetNodeCapacity());
+  TestEqualInt(strings, context.GetStringCapacity());
+
+  v["tags"].SetNumber(2.0);
+  TestEqualInt(kOk, v.Parse("[\"reused\",[]]", context));
+  TestEqualInt(kString, v[0].GetType());
+  TestEqualInt(0, v[1].GetArraySize());
+
+  TestEqualInt(kMissCommaOrSquareBracket, v.Parse("[1,{\"a\":[2]}", context));
+  TestEqualInt(kNull, v.GetType());
+  TestEqualInt(kMissQuotationMark, v.Parse("{\"a", context));
+  TestEqualInt(kNotSingular, v.Parse("[1] 2", context));
+  TestEqualInt(kNull, v.GetType());
+
+  Value heap;
+  TestEqualInt(kMissQuotationMark, heap.Parse("{\"a"));
+  TestEqualInt(kOk, heap.Parse("{\"a\":1,\"a\":2}"));
+  TestEqualInt(1, heap.GetObjectSize());
+  TestEqualDouble(1.0, heap["a"].GetNumber());
+}
+
+static void TestParseInteger() {
+  Value v;
+  TestEqualInt(kOk, v.Parse("123"));
+  TestTrue(v.IsInt64());
+  TestTrue(v.IsUint64());
+  TestEqualInt(123, v.GetInt64());
+
+  TestEqualInt(kOk, v.Parse("-9223372036854775808"));
+  TestTrue(v.IsInt64());
+  TestFalse(v.IsUint64());
+  TestTrue(v.GetInt64() == INT64_MIN);
+  TestEqualDouble(-9223372036854775808.0, v.GetNumber());
+
+  TestEqualInt(kOk, v.Parse("9223372036854775807"));
+  TestTrue(v.GetInt64() == INT64_MAX);
+  TestEqualInt(kOk, v.Parse("18446744073709551615"));
+  TestFalse(v.IsInt64());
+  TestTrue(v.GetUint64() == UINT64_MAX);
+  TestEqualInt(kOk, v.Parse("505874924095815681"));
+  TestTrue(v.GetInt64() == 505874924095815681LL);
+
+  TestEqualInt(kOk, v.Parse("18446744073709551616"));
+  TestFalse(v.IsUint64());
+  TestEqualDouble(18446744073709551616.0, v.GetNumber());
+  TestEqualInt(kOk, v.Parse("-9223372036854775809"));
+  TestFalse(v.IsInt64());
+  TestEqualInt(kOk, v.Parse("-0"));
+  TestFalse(v.IsInt64());
+  TestEqualInt(kOk, v.Parse("1.0"));
+  TestFalse(v.IsInt64());
+  TestEqualInt(kOk, v.Parse("1e2"));
+  TestFalse(v.IsInt64());
+
+  v.SetInt64(-42);
+  TestEqualDouble(-42.0, v.GetNumber());
+  v.SetUint64(42);
+  TestEqualInt(42, v.GetInt64());
+  v.SetNumber(42.0);
+  TestFalse(v.IsInt64());
+
+  TestRoundtrip("-9223372036854775808");
+  TestRoundtrip("9223372036854775807");
+  TestRoundtrip("18446744073709551615");
+  TestRoundtrip("505874924095815681");
+  TestRoundtrip("[0,-1,10,-100,1000]");
+}
+
+#define TestRawRoundtrip(json)\
+  do {\
+    Value v;\
+    std::string json2;\
+    TestEqualInt(kOk, v.Parse(json, kParseRawNumbers));\
+    TestEqualInt(kOk, v.Stringify(json2));\
+    TestEqualString(json, json2.c_str(), json2.length());\
+  } while(0)
+
+static void TestParseRawNumber() {
+  Value v;
+  TestEqualInt(kOk, v.Parse("1.5E+10", kParseRawNumbers));
+  TestEqualInt(kNumber, v.GetType());
+  TestEqualDouble(1.5E+10, v.GetNumber());
+  TestFalse(v.IsInt64());
+  TestEqualInt(kOk, v.Parse("18446744073709551615", kParseRawNumbers));
+  TestTrue(v.GetUint64() == UINT64_MAX);
+  TestEqualInt(kOk, v.Parse("-12", kParseRawNumbers));
+  TestTrue(v.GetInt64() == -12);
+  TestEqualDouble(-12.0, v.GetNumber());
+
+  TestRawRoundtrip("1E10");
+  TestRawRoundtrip("-0.0");
+  TestRawRoundtrip("1.50");
+  TestRawRoundtrip("[0.10,2e-3,{\"a\":12345678901234567890123}]");
+
+  TestEqualInt(kNumberTooBig, v.Parse("1e309", kParseRawNumbers));
+  TestEqualInt(kNumberTooBig, v.Parse("[-123.4e307]", kParseRawNumbers));
+  TestEqualInt(kOk, v.Parse("1.7e308", kParseRawNumbers));
+  TestEqualInt(kOk, v.Parse("1e-400", kParseRawNumbers));
+  TestEqualInt(kInvalidValue, v.Parse("1.", kParseRawNumbers));
+  TestEqualInt(kNull, v.GetType());
+
+  ParserContext context;
+  TestEqualInt(kOk, v.Parse("[1.25,2]", context, kParseRawNumbers));
+  TestEqualDouble(1.25, v[0].GetNumber());
+  TestEqualInt(kOk, v.Parse("[3.5,4]", context, kParseRawNumbers));
+  TestEqualDouble(3.5, v[0].GetNumber());
+  TestEqualInt(4, v[1].GetInt64());
+  TestEqualInt(2, context.GetRawNumberCapacity());
+
+  v[0].SetNumber(1.0);
+  std::string json;
+  v.Stringify(json);
+  TestEqualString("[1,4]", json.c_str(), json.length());
+}
+
+static void TestParseDepth() {
+  Value v;
+  std::string deep(kDefaultMaxDepth, '[');
+  deep.append(kDefaultMaxDepth, ']');
+  TestEqualInt(kOk, v.Parse(deep.c_str()));
+  TestEqualInt(1, v.GetArraySize());
+  std::string text;
+  v.Stringify(text);
+  TestTrue(text == deep);
+
+  std::string hostile(1000000, '[');
+  TestEqualInt(kDepthLimitExceeded, v.Parse(hostile.c_str()));
+  TestEqualInt(kNull, v.GetType());
+  TestEqualInt(kDepthLimitExceeded, v.Parse(("[" + deep + "]").c_str()));
+
+  std::string objects;
+  for(int i = 0; i < 100; ++i) {
+    objects += "{\"a\":[0,";
+  }
+  TestEqualInt(kExpectValue, v.Parse(objects.c_str()));
+  TestEqualInt(kMissCommaOrCurlyBracket, v.Parse("{\"a\":[{\"b\":1]]}"));
+
+  ParserContext context;
+  context.SetMaxDepth(2);
+  TestEqualInt(kOk, v.Parse("[{\"a\":1},[2]]", context));
+  TestEqualInt(2, context.GetStackCapacity());
+  TestEqualInt(kDepthLimitExceeded, v.Parse("[{\"a\":[1]}]", context));
+  TestEqualInt(kOk, v.Parse("{\"a\":{},\"b\":[]}", context));
+  TestEqualInt(2, v.GetObjectSize());
+}
+
+static void TestFreeTree() {
+  CountingAllocator allocator;
+  SetAllocator(&allocator);
+  {
+    Value deep;
+    for(int i = 0; i < 1000000; ++i) {
+      std::vector<Value *> elements(1, new Value());
+      elements[0]->Swap(deep);
+      deep.SetArray(elements);
+    }
+    TestEqualInt(1000000, allocator.GetAllocations());
+    deep.SetNumber(1.0);
+    TestEqualInt(1000000, allocator.GetDeallocations());
+
+    Value v;
+    TestEqualInt(kOk, v.Parse("[1,[2,3],{\"k\":[4]}]"));
+    allocator.Reset();
+    v.FreeInBackground();
+    TestEqualInt(kNull, v.GetType());
+    WaitForBackgroundFree();
+    TestEqualInt(0, GetBackgroundFreePending());
+    TestEqualInt(8, allocator.GetDeallocations());
+  }
+  TestEqualInt(0, allocator.GetLiveBytes());
+  SetAllocator(nullptr);
+}
+
+struct TestUser {
+  std::string name;
+  int64_t id;
+  bool active;
+  std::vector<std::string> tags;
+};
+TINKER_JSON_FIELDS(TestUser, name, id, active, tags)
+
+struct TestTeam {
+  std::string title;
+  double score;
+  unsigned char_count;
+  std::vector<TestUser> members;
+  std::map<std::string, int> ranks;
+  Value extra;
+};
+TINKER_JSON_FIELDS(TestTeam, title, score, char_count, members, ranks, extra)
+
+struct TestFlags {
+  std::vector<bool> flags;
+};
+TINKER_JSON_FIELDS(TestFlags, flags)
+
+static void TestStructMapping() {
+  const char *json = "{\"title\":\"core\",\"unknown\":{\"a\":[1,{}]},"
+    "\"members\":[{\"name\":\"Li\\n\",\"id\":-7,\"active\":true,"
+    "\"tags\":[\"x\",\"y\"]},{\"id\":9007199254740993}],"
+    "\"score\":2.5,\"char_count\":3,\"ranks\":{\"b\":2,\"a\":1},"
+    "\"extra\":[null,{\"k\":false}]}";
+  TestTeam team;
+  team.members.push_back(TestUser());
+  TestEqualInt(kOk, Tinker::Parse(json, team));
+  TestEqualString("core", team.title.c_str(), 4);
+  TestEqualDouble(2.5, team.score);
+  TestEqualInt(3, team.char_count);
+  TestEqualInt(2, team.members.size());
+  TestEqualString("Li\n", team.members[0].name.c_str(), 3);
+  TestTrue(team.members[0].id == -7);
+  TestTrue(team.members[0].active);
+  TestEqualInt(2, team.members[0].tags.size());
+  TestTrue(team.members[1].id == 9007199254740993LL);
+  TestEqualInt(2, team.ranks["b"]);
+  TestEqualInt(kArray, team.extra.GetType());
+  TestEqualInt(kFalse, team.extra[1]["k"].GetType());
+
+  std::string text;
+  TestEqualInt(kOk, Tinker::Stringify(team.members[0], text));
+  TestTrue(text == "{\"name\":\"Li\\n\",\"id\":-7,\"active\":true,"
+    "\"tags\":[\"x\",\"y\"]}");
+  text.clear();
+  Tinker::Stringify(team, text);
+  TestTeam copy;
+  TestEqualInt(kOk, Tinker::Parse(text.c_str(), copy));
+  std::string again;
+  Tinker::Stringify(copy, again);
+  TestTrue(text == again);
+
+  TestUser user;
+  TestEqualInt(kTypeMismatch, Tinker::Parse("{\"id\":\"7\"}", user));
+  TestEqualInt(kTypeMismatch, Tinker::Parse("{\"id\":1.5}", user));
+  TestEqualInt(kTypeMismatch, Tinker::Parse("[]", user));
+  TestEqualInt(kNumberTooBig, Tinker::Parse("{\"char_count\":-1}", copy));
+  TestEqualInt(kNumberTooBig,
+    Tinker::Parse("{\"char_count\":4294967296}", copy));
+  TestEqualInt(kMissCommaOrCurlyBracket, Tinker::Parse("{\"id\":1 2}", user));
+  TestEqualInt(kMissCommaOrSquareBracket,
+    Tinker::Parse("{\"tags\":[\"a\" \"b\"]}", user));
+  TestEqualInt(kNotSingular, Tinker::Parse("{} {}", user));
+  TestEqualInt(kInvalidValue, Tinker::Parse("{\"x\":[1,]}", user));
+  std::vector<std::vector<int> > nested;
+  TestEqualInt(kOk, Tinker::Parse(" [ [1, 2] , [ ] ] ", nested));
+  TestEqualInt(2, nested[0][1]);
+  TestEqualInt(0, nested[1].size());
+  TestTrue(HashKey("members") == HashKeyLiteral("members"));
+
+  TestFlags flags;
+  TestEqualInt(kOk, Tinker::Parse("{\"flags\":[true,false,true]}", flags));
+  TestEqualInt(3, flags.flags.size());
+  TestTrue(flags.flags[0] && !flags.flags[1] && flags.flags[2]);
+  text.clear();
+  Tinker::Stringify(flags, text);
+  TestTrue(text == "{\"flags\":[true,false,true]}");
+  TestEqualInt(kTypeMismatch, Tinker::Parse("{\"flags\":[1]}", flags));
+}
+
+static void TestValidate() {
+  size_t offset = 0;
+  const char *json = "{\"a\":[1,2.5e3,\"\\u00e9\"]} ";
+  TestEqualInt(kOk, Validate(json, strlen(json), offset));
+  TestEqualInt(strlen(json), offset);
+  TestEqualInt(kMissCommaOrSquareBracket, Validate("[1,2 3]", 7, offset));
+  TestEqualInt(5, offset);
+  TestEqualInt(kInvalidStringChar, Validate("\"ab\ncd\"", 7, offset));
+  TestEqualInt(3, offset);
+
+  const char *truncated = "[\"abc\", true]";
+  TestEqualInt(kMissQuotationMark, Validate(truncated, 4));
+  TestEqualInt(kInvalidValue, Validate(truncated, 10));
+  TestEqualInt(kMissCommaOrSquareBracket, Validate(truncated, 12));
+  TestEqualInt(kOk, Validate(truncated, 13));
+  TestEqualInt(kOk, Validate(truncated, 14));
+  TestEqualInt(kNotSingular, Validate("[] \0[]", 6));
+  std::string padded(40, ' ');
+  padded += "\"a long string without any escape in it at all\"";
+  padded += std::string(40, '\n');
+  TestEqualInt(kOk, Validate(padded.c_str(), padded.length()));
+
+  const char *numbers[] = {
+    "1.7976931348623157e308",
+    "1.7976931348623158e308",
+    "1.797693134862315807937289714053e308",
+    "1.797693134862315807937289714054e308",
+    "-1.7976931348623159e308",
+    "179769313486231580793728971405303415079934132710037826936173778980444"
+    "396829276475094664901797758720709633028641669288791094655554785194040"
+    "263065748867150582068190890200070838367627385484581771153176447573027"
+    "006985557136695962284291481986083493647529271907416844436551070434271"
+    "1559699508093042880177904174497791.9999",
+    "0.00017976931348623159e312",
+    "1e308",
+    "10e308",
+    "0.1e309",
+    "1e-400",
+    "0e99999999"
+  };
+  for(size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i) {
+    Value v;
+    TestEqualInt(v.Parse(numbers[i]),
+      Validate(numbers[i], strlen(numbers[i])));
+  }
+
+  TestError(kNotSingular, "-01e309");
+  TestError(kNotSingular, "-0x1p9999");
+
+  std::string deep(kDefaultMaxDepth, '[');
+  deep.append(kDefaultMaxDepth, ']');
+  TestEqualInt(kOk, Validate(deep.c_str(), deep.length()));
+  deep = "{\"a\":" + deep + "}";
+  TestEqualInt(kDepthLimitExceeded, Validate(deep.c_str(), deep.length()));
+
+  const char *files[] = {
+    "test/twitter.json",
+    "test/canada.json",
+    "test/citm_catalog.json",
+  };
+  for(int i = 0; i < 3; ++i) {
+    std::ifstream is(files[i], std::ifstream::binary);
+    std::string text((std::istreambuf_iterator<char>(is)),
+      std::istreambuf_iterator<char>());
+    Value v;
+    TestEqualInt(v.Parse(text.c_str()), Validate(text.c_str(), text.length()));
+  }
+}
+
+static void TestValidateUtf8() {
+  Value v;
+  const char *valid[] = {
+    "\"caf\xC3\xA9\"",
+    "\"\xE3\x81\x82\xE3\x81\x84 and \xF0\x9F\x98\x80 in a longer string\"",
+    "{\"\xE2\x82\xAC\":\"\xED\x9F\xBF\xEE\x80\x80\xF4\x8F\xBF\xBF\"}",
+    "\"\\uD834\\uDD1E\\u00e9\""
+  };
+  for(size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); ++i) {
+    TestEqualInt(kOk, v.Parse(valid[i], kParseValidateUtf8));
+    TestEqualInt(kOk,
+      Validate(valid[i], strlen(valid[i]), kParseValidateUtf8));
+  }
+
+  const char *invalid[] = {
+    "\"\x80\"",
+    "\"\xC0\xAF\"",
+    "\"\xC3\"",
+    "\"\xE0\x9F\xBF\"",
+    "\"\xED\xA0\x80\"",
+    "\"\xF0\x8F\xBF\xBF\"",
+    "\"\xF4\x90\x80\x80\"",
+    "\"\xF5\x80\x80\x80\"",
+    "\"\xE3\x81\"",
+    "[\"0123456789abcde\xE3\x81\x82\xE3\x81\xFF" "0123456789\"]",
+    "{\"ke\xFFy\":1}"
+  };
+  for(size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+    TestEqualInt(kOk, v.Parse(invalid[i]));
+    TestEqualInt(kInvalidUtf8, v.Parse(invalid[i], kParseValidateUtf8));
+    TestEqualInt(kInvalidUtf8,
+      Validate(invalid[i], strlen(invalid[i]), kParseValidateUtf8));
+  }
+
+  size_t offset = 0;
+  const char *json = "[\"abcdefghijklmnopqrstuvwxyz\xE2\x82\xAC\xE2\x82\"]";
+  TestEqualInt(kInvalidUtf8,
+    Validate(json, strlen(json), offset, kParseValidateUtf8));
+  TestEqualInt(31, offset);
+
+  TestEqualInt(kOk, v.Parse("\"\\uDC00\""));
+  TestEqualInt(kInvalidUnicodeSurrogate,
+    v.Parse("\"\\uDC00\"", kParseValidateUtf8));
+  TestEqualInt(kInvalidUnicodeSurrogate,
+    Validate("\"\\uDFFF\"", 8, kParseValidateUtf8));
+}
+
+static void TestSimdLevels() {
+  TestTrue(IsSimdLevelSupported(kSimdScalar));
+  TestTrue(IsSimdLevelSupported(GetBestSimdLevel()));
+  TestEqualInt(GetBestSimdLevel(), GetSimdLevel());
+
+  // Errors at every distance from the start of the scans
+  for(int level = kSimdScalar; level <= kSimdNeon; ++level) {
+    if(!SetSimdLevel((SimdLevel)level)) {
+      TestTrue(!IsSimdLevelSupported((SimdLevel)level));
+      continue;
+    }
+    TestEqualInt(level, GetSimdLevel());
+    for(size_t at = 0; at < 150; at += 7) {
+      std::string prefix = std::string(at, ' ') + "\"" + std::string(at, 'a');
+      std::string valid = prefix + "\xC3\xA9" + std::string(100, 'b') + "\"";
+      std::string bad_utf8 = prefix + "\xC3(" + std::string(100, 'b') + "\"";
+      std::string bad_char = prefix + "\x01" + std::string(100, 'b') + "\"";
+      size_t offset = 0;
+      TestEqualInt(kOk,
+        Validate(valid.c_str(), valid.length(), kParseValidateUtf8));
+      TestEqualInt(kInvalidUtf8, Validate(bad_utf8.c_str(), bad_utf8.length(),
+        offset, kParseValidateUtf8));
+      TestEqualInt(prefix.length(), offset);
+      TestEqualInt(kInvalidStringChar,
+        Validate(bad_char.c_str(), bad_char.length()));
+
+      // The escaped character adds 4 bytes, the quotation marks 2
+      Value v;
+      std::string str;
+      v.SetString(valid.c_str() + at + 1, valid.length() - at - 2);
+      v.Stringify(str, kStringifyEnsureAscii);
+      TestEqualInt(valid.length() - at + 4, str.length());
+    }
+  }
+  SetSimdLevel(GetBestSimdLevel());
 }
 
 void CaseTest() {
@@ -394,6 +1805,31 @@ void CaseTest() {
   TestStringifyString();
   TestStringifyArray();
   TestStringifyObject();
+  TestStringifyAscii();
+  TestStringifyCached();
+  TestParseParallel();
+  TestStringifyParallel();
+  TestSharedDocument();
+  TestDeduplicate();
+  TestPatch();
+  TestCompare();
+  TestIterate();
+  TestFind();
+  TestArrayReader();
+#ifdef TINKER_JSON_ZLIB
+  TestGzip();
+#endif
+  TestSimdLevels();
+  TestMemoryStats();
+  TestParserStats();
+  TestParseContext();
+  TestParseInteger();
+  TestParseRawNumber();
+  TestParseDepth();
+  TestFreeTree();
+  TestStructMapping();
+  TestValidate();
+  TestValidateUtf8();
 }
 
 static double TestParseFile(const char *filename) {